@@ -0,0 +1,53 @@
+#ifndef AGGREGATING_OBSERVER_H
+#define AGGREGATING_OBSERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "NPCType.h"
+#include "Observer.h"
+
+// Counts kills by killer and victim type, over the whole battle and for each
+// of the last HISTORY rounds, in atomic counters allocated once up front.
+// on_kill neither allocates nor locks, and every query may run on another
+// thread while a battle is still delivering events. Events must come from
+// one thread at a time, which is how Arena delivers them.
+class AggregatingObserver final: public IObserver
+{
+public:
+    static constexpr size_t HISTORY = 64;
+private:
+    size_t types;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> totals;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> rounds;
+    // Round held by each history slot, plus one; 0 marks an empty slot.
+    std::unique_ptr<std::atomic<std::uint64_t>[]> slot_rounds;
+    std::atomic<std::uint64_t> kill_total{0};
+    std::atomic<std::uint64_t> untracked{0};
+    std::atomic<std::uint64_t> last_round{0};
+public:
+    // Sized for the types registered when it is created; kills involving
+    // types registered later are only counted by untracked_count().
+    AggregatingObserver();
+    explicit AggregatingObserver(size_t types);
+public:
+    void on_round(std::span<const KillEvent> events) override;
+    void on_kill(const KillEvent& event) override;
+public:
+    size_t type_count() const;
+    std::uint64_t total() const;
+    std::uint64_t total(NPCType killer, NPCType victim) const;
+    // Kills in the given round; 0 once the round has left the history.
+    std::uint64_t in_round(size_t round, NPCType killer, NPCType victim) const;
+    std::uint64_t in_round(size_t round) const;
+    // Highest round that had a kill, plus one; 0 before the first kill.
+    std::uint64_t rounds_seen() const;
+    std::uint64_t untracked_count() const;
+    // Must not run while events are being delivered.
+    void reset();
+private:
+    size_t cell(NPCType killer, NPCType victim) const;
+};
+
+#endif //AGGREGATING_OBSERVER_H
\ No newline at end of file
@@ -1,34 +1,174 @@
 #ifndef ARENA_H
 #define ARENA_H
 
+#include <chrono>
+#include <iostream>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
+#include "BattleStats.h"
+#include "EventPipeline.h"
 #include "Observer.h"
 #include "NPC.h"
+#include "NPCPool.h"
+#include "NPCStore.h"
+#include "NPCType.h"
+#include "PairQueue.h"
+#include "PopulationGenerator.h"
+#include "RadiusSchedule.h"
+#include "RuleTable.h"
+#include "SpatialIndex.h"
+#include "ThreadPool.h"
 
+// Sequential applies kills pair by pair in index order, so an NPC killed
+// earlier in a round no longer attacks. Simultaneous decides every kill of a
+// round from the state at its start and applies them together, which lets the
+// decision phase run in parallel.
+enum class ResolutionMode
+{
+    Sequential,
+    Simultaneous
+};
+
+enum class FileFormat
+{
+    Text,
+    Binary
+};
+
+// What battle reports about the survivors at the start of every round. Full
+// lists every living NPC; Summary prints one line of per-type counts;
+// Sampled prints the counts and up to survivor_sample NPCs spread evenly over
+// the store; FinalOnly lists the survivors once, after the last round.
+enum class SurvivorReport
+{
+    Full,
+    Summary,
+    Sampled,
+    FinalOnly,
+    Off
+};
+
+// Per-instance outputs. An empty path disables the corresponding output, and
+// all paths are empty by default; get_instance() keeps the historical
+// ../logs.txt and ../res.txt. Console output (survivor reports and kill
+// lines) goes to the console stream.
+// Battle statistics are written to stats_path after every battle, and kills
+// are recorded in the binary kill log at kill_log_path. The text log at
+// log_path is rotated and synced as described for MappedLogObserver; an
+// Arena whose log_path is held by another Arena throws std::runtime_error.
+struct ArenaConfig
+{
+    std::string log_path{};
+    std::string result_path{};
+    bool console_log = true;
+    std::ostream* console = &std::cout;
+    std::string stats_path{};
+    StatsFormat stats_format = StatsFormat::JsonLines;
+    std::string kill_log_path{};
+    SurvivorReport survivor_report = SurvivorReport::Full;
+    size_t survivor_sample = 16;
+    size_t log_rotate_bytes = 0;
+    std::chrono::milliseconds log_sync_interval = std::chrono::seconds(1);
+};
+
+// The only state Arenas share is the process-wide TypeRegistry, which is
+// thread-safe: a type registered through one Arena, for instance by
+// load_rules, gets the same code in every other. Apart from that, independent
+// instances can battle on different threads at the same time, provided their
+// output paths differ. get_instance() returns a process-wide default instance.
 class Arena final
 {
 private:
-    std::vector<std::shared_ptr<NPC>> npcs;
+    ArenaConfig config;
+    NPCStore npcs;
+    mutable NPCPool npc_pool;
     std::vector<std::shared_ptr<IObserver>> observers;
-private:
-    Arena();
+    size_t radius_step = 10;
+    double compaction_threshold = 0.5;
+    double dense_threshold = 0.1;
+    SpatialIndexKind spatial_index = SpatialIndexKind::Grid;
+    RuleTable rules = RuleTable::builtin();
+    mutable std::unique_ptr<ISpatialIndex> region_index;
+    ResolutionMode resolution = ResolutionMode::Sequential;
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<EventPipeline> pipeline;
+    // Kills of the current round not yet handed to the observers.
+    std::vector<KillEvent> round_events;
+    BattleStats stats;
 public:
+    Arena();
+    explicit Arena(ArenaConfig config);
     Arena(const Arena&) = delete;
     Arena& operator=(const Arena&) = delete;
 public:
     static Arena& get_instance();
 public:
-    void add_npc(const std::string& type, int x, int y);
+    const ArenaConfig& get_config() const;
+    void add_observer(std::shared_ptr<IObserver> observer);
+    void clear_observers();
 public:
-    void save_to_file(const std::string& filename) const ;
+    NPCHandle add_npc(const std::string& type, int x, int y);
+    NPCHandle add_npc(NPCType type, int x, int y);
+    // Appends whole columns at once. The new NPCs get consecutive handle ids
+    // starting from the returned handle.
+    NPCHandle add_npcs(std::span<const int> x, std::span<const int> y, std::span<const NPCType> types);
+    NPCHandle add_npcs(const Population& population);
+    // Generates spec.count NPCs on the arena's worker threads and adds them.
+    NPCHandle populate(const PopulationSpec& spec);
+    std::shared_ptr<NPC> get_npc(NPCHandle handle) const;
+    const NPCStore& get_npcs() const;
+    const NPCPool& get_npc_pool() const;
+public:
+    // Index used by battle and by region queries.
+    void set_spatial_index(SpatialIndexKind kind);
+    SpatialIndexKind get_spatial_index() const;
+    // Handles of the living NPCs within radius of (x, y), in store order.
+    std::vector<NPCHandle> query_region(int x, int y, size_t radius) const;
+public:
+    void save_to_file(const std::string& filename, FileFormat format = FileFormat::Text) const ;
+    // Detects binary snapshots by their magic number and falls back to text.
     void load_from_file(const std::string& filename);
 public:
     void print_survivors() const;
+    void set_survivor_report(SurvivorReport mode, size_t sample = 16);
 public:
+    void set_radius_step(size_t step);
     void battle(size_t distance);
+    void battle(const RadiusSchedule& schedule);
+    const BattleStats& get_battle_stats() const;
+    // Dead NPCs are compacted out of the store at a round boundary once they
+    // make up this share of it. Values above 1 disable compaction.
+    void set_compaction_threshold(double ratio);
+    // Rounds whose radius is expected to reach more than this share of the
+    // other NPCs scan all pairs with DenseKernel instead of building pairs
+    // through the spatial index. Values of 1 or more disable the switch.
+    void set_dense_threshold(double fraction);
+public:
+    // Kill rules used by battle; the built-in rules unless replaced. A rules
+    // file may introduce new types, which add_npc and the loaders then accept.
+    void load_rules(const std::string& filename);
+    void set_rules(const RuleTable& table);
+    const RuleTable& get_rules() const;
+public:
+    void set_resolution_mode(ResolutionMode mode);
+    void set_thread_count(size_t threads);
+    void set_async_observers(bool enabled, size_t capacity = 1 << 16, BackPressure policy = BackPressure::Block);
 public:
     void clear_npcs();
+private:
+    void resolve_sequential(std::span<const NPCPair> pairs, RoundStats& round);
+    void resolve_simultaneous(std::span<const NPCPair> pairs, RoundStats& round);
+    void resolve_dense(std::optional<size_t> inner, size_t outer, RoundStats& round);
+    void apply_kills(const std::vector<std::vector<NPCPair>>& kills, RoundStats& round);
+    void report_survivors(const RoundStats& round, const std::vector<std::pair<NPCType, size_t>>& alive_by_type) const;
+    void begin_observers(const RoundStats& round);
+    void notify(const NPCPair& pair, const RoundStats& round);
+    void deliver_events();
+    void end_observers(const RoundStats& round);
 };
 
 #endif //ARENA_H
\ No newline at end of file
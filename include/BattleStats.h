@@ -0,0 +1,72 @@
+#ifndef BATTLE_STATS_H
+#define BATTLE_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "NPCType.h"
+
+enum class StatsFormat
+{
+    Prometheus,
+    JsonLines
+};
+
+// Counters for one round of Arena::battle. in_range_pairs are the pairs that
+// came into range this round, less those dropped by compaction;
+// pairs_considered are those of them that still had both sides alive and were
+// checked against the kill table. Dense rounds never see pairs with a side
+// already dead, so they only count those, and they record their own
+// distance_tests. compacted counts the dead NPCs moved out of the store after
+// the round. kills is a type_count x type_count matrix indexed killer-major,
+// sized for every type registered when the round began. Phase times are
+// wall-clock milliseconds.
+struct RoundStats
+{
+    size_t round = 0;
+    size_t radius = 0;
+    std::uint64_t in_range_pairs = 0;
+    std::uint64_t pairs_considered = 0;
+    std::uint64_t distance_tests = 0;
+    size_t type_count = 0;
+    std::vector<std::uint64_t> kills;
+    size_t alive = 0;
+    size_t compacted = 0;
+    double report_ms = 0;
+    double resolve_ms = 0;
+    double notify_ms = 0;
+    double compact_ms = 0;
+
+    void add_kill(NPCType killer, NPCType victim);
+    std::uint64_t kill_count() const;
+    std::uint64_t kill_count(NPCType killer, NPCType victim) const;
+};
+
+// Statistics of the last battle. Distance tests done while building the pair
+// queue are accounted to the index phase, not to a round.
+class BattleStats final
+{
+private:
+    size_t npcs = 0;
+    std::uint64_t index_distance_tests = 0;
+    double index_ms = 0;
+    std::vector<RoundStats> rounds;
+public:
+    void reset(size_t npcs);
+    void set_index(double ms, std::uint64_t distance_tests);
+    RoundStats& add_round(size_t radius);
+public:
+    size_t get_npcs() const;
+    std::uint64_t get_index_distance_tests() const;
+    double get_index_ms() const;
+    const std::vector<RoundStats>& get_rounds() const;
+    // Sum of all rounds; alive is the count after the last round.
+    RoundStats totals() const;
+public:
+    void write(std::ostream& out, StatsFormat format) const;
+    void write_prometheus(std::ostream& out) const;
+    void write_json_lines(std::ostream& out) const;
+};
+
+#endif //BATTLE_STATS_H
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+
+// Formats text into a fixed buffer and hands it to the stream in large
+// writes. Numbers go through std::to_chars, so no locale or stream state is
+// involved. Whatever is buffered is written on flush() and on destruction.
+class BufferedWriter final
+{
+public:
+    static constexpr size_t CAPACITY = 1 << 16;
+private:
+    std::ostream& out;
+    std::unique_ptr<char[]> buffer;
+    size_t used = 0;
+public:
+    explicit BufferedWriter(std::ostream& out);
+    ~BufferedWriter();
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+public:
+    BufferedWriter& operator<<(std::string_view text);
+    BufferedWriter& operator<<(char c);
+
+    template<typename T> requires std::is_integral_v<T>
+    BufferedWriter& operator<<(T value)
+    {
+        constexpr size_t DIGITS = 24;
+        if (CAPACITY - used < DIGITS)
+        {
+            flush();
+        }
+        used = std::to_chars(buffer.get() + used, buffer.get() + CAPACITY, value).ptr - buffer.get();
+        return *this;
+    }
+
+    void flush();
+};
+
+#endif //BUFFERED_WRITER_H
\ No newline at end of file
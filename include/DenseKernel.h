@@ -0,0 +1,38 @@
+#ifndef DENSE_KERNEL_H
+#define DENSE_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "RadiusSchedule.h"
+
+// All-pairs scan for rounds whose radius covers most of the map, where any
+// spatial index would return nearly everyone. Attackers are taken in blocks
+// of BLOCK; each block sweeps the defender coordinates tile by tile, so a
+// tile of TILE defenders (32 KiB of coordinates) stays in L1 while every
+// attacker of the block is tested against it with DistanceKernel.
+class DenseKernel final
+{
+public:
+    static constexpr size_t BLOCK = 64;
+    static constexpr size_t TILE = 4096;
+public:
+    // First round whose radius is expected to reach more than threshold of
+    // the other NPCs, taking them as spread evenly over their bounding box
+    // and clipping the circle to it; schedule.rounds() if there is none. Radii never decrease, so every
+    // later round qualifies too.
+    static size_t first_dense_round(const std::vector<int>& xs, const std::vector<int>& ys,
+                                    const RadiusSchedule& schedule, double threshold);
+    // Fills one row of (xs.size() + 63) / 64 words per attacker in
+    // [first, first + count): bit j of row a is set when defender j is in
+    // candidates, differs from the attacker, and lies within outer but not
+    // within inner. Attackers missing from candidates get empty rows.
+    // Returns the number of distance tests done.
+    static std::uint64_t band_rows(const std::vector<int>& xs, const std::vector<int>& ys, size_t first, size_t count,
+                                   std::optional<size_t> inner, size_t outer, std::span<const std::uint64_t> candidates,
+                                   std::vector<std::uint64_t>& rows);
+};
+
+#endif //DENSE_KERNEL_H
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef DISTANCE_KERNEL_H
+#define DISTANCE_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Batch form of NPC::is_close: one attacker against a block of up to 64
+// defenders stored in contiguous coordinate arrays. Bit k of the result is set
+// when defender k is within the radius. Distances are accumulated in unsigned
+// 64-bit lanes, so any pair of int coordinates is handled without overflow.
+// The implementation is picked once at runtime from the CPU features.
+class DistanceKernel final
+{
+public:
+    static constexpr size_t BLOCK = 64;
+
+    enum class Isa
+    {
+        Scalar,
+        SSE,
+        AVX2
+    };
+public:
+    static std::uint64_t in_range_mask(int x, int y, const int* xs, const int* ys, size_t count, size_t radius);
+public:
+    static Isa get_isa();
+    static bool is_supported(Isa isa);
+    static void set_isa(Isa isa);
+};
+
+#endif //DISTANCE_KERNEL_H
\ No newline at end of file
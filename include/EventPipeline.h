@@ -0,0 +1,76 @@
+#ifndef EVENT_PIPELINE_H
+#define EVENT_PIPELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Observer.h"
+#include "RingBuffer.h"
+
+// What push does when the queue is full.
+enum class BackPressure
+{
+    Block,
+    DropOldest,
+    CountDrops
+};
+
+// Moves observer calls off the battle thread. The battle pushes kill events
+// into a lock-free ring and a dispatcher thread hands them to the observers
+// through on_round in batches. begin_round, end_round and flush are barriers:
+// each returns once every accepted event has been delivered and the matching
+// observer hook has run on the dispatcher thread.
+class EventPipeline final
+{
+private:
+    static constexpr size_t BATCH = 1024;
+
+    enum class Control
+    {
+        Begin,
+        End,
+        Flush
+    };
+
+    std::vector<std::shared_ptr<IObserver>> observers;
+    RingBuffer<KillEvent> queue;
+    BackPressure policy;
+    std::atomic<size_t> accepted{0};
+    std::atomic<size_t> retired{0};
+    std::atomic<size_t> delivered{0};
+    std::atomic<size_t> dropped{0};
+    std::atomic<size_t> signal{0};
+    // Written by the battle thread before a request is published.
+    Control control = Control::Flush;
+    std::uint32_t control_round = 0;
+    std::uint64_t control_radius = 0;
+    std::atomic<size_t> control_requested{0};
+    std::atomic<size_t> control_completed{0};
+    std::atomic<bool> idle{false};
+    std::atomic<bool> stopping{false};
+    std::thread dispatcher;
+public:
+    EventPipeline(std::vector<std::shared_ptr<IObserver>> observers, size_t capacity, BackPressure policy);
+    ~EventPipeline();
+    EventPipeline(const EventPipeline&) = delete;
+    EventPipeline& operator=(const EventPipeline&) = delete;
+public:
+    void push(const KillEvent& event);
+    void begin_round(std::uint32_t round, std::uint64_t radius);
+    void end_round(std::uint32_t round);
+    void flush();
+public:
+    size_t delivered_count() const;
+    size_t dropped_count() const;
+    size_t get_capacity() const;
+    BackPressure get_policy() const;
+private:
+    void request(Control kind, std::uint32_t round, std::uint64_t radius);
+    void wake();
+    void dispatch_loop();
+};
+
+#endif //EVENT_PIPELINE_H
\ No newline at end of file
@@ -4,11 +4,17 @@
 #include <string>
 #include <memory>
 #include "NPC.h"
+#include "NPCPool.h"
+#include "NPCStore.h"
+#include "NPCType.h"
 
 class INPCFactory
 {
 public:
     static std::shared_ptr<NPC> create_npc(const std::string& type, int x, int y);
+    static std::shared_ptr<NPC> create_npc(NPCType type, int x, int y);
+    static std::shared_ptr<NPC> create_npc(NPCType type, int x, int y, NPCPool& pool);
+    static NPCHandle create_npc(NPCStore& store, const std::string& type, int x, int y);
 };
 
 #endif //FACTORY_H
\ No newline at end of file
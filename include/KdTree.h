@@ -0,0 +1,45 @@
+#ifndef KD_TREE_H
+#define KD_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SpatialIndex.h"
+
+// Bulk-loaded k-d tree. Nodes split at the median of their wider side, so the
+// tree stays balanced however clustered the points are, and memory is linear
+// in the number of points rather than in the area they cover. Leaves hold up
+// to LEAF points stored contiguously for DistanceKernel; a node whose bounding
+// box lies entirely inside the query circle is reported without any tests.
+class KdTree final: public ISpatialIndex
+{
+public:
+    static constexpr std::size_t LEAF = 32;
+private:
+    struct Node
+    {
+        int min_x;
+        int max_x;
+        int min_y;
+        int max_y;
+        std::uint32_t begin;
+        std::uint32_t end;
+        std::uint32_t left;
+        std::uint32_t right;
+    };
+private:
+    std::vector<Node> nodes;
+    std::vector<std::size_t> ids;
+    std::vector<int> xs;
+    std::vector<int> ys;
+public:
+    KdTree(const std::vector<int>& x, const std::vector<int>& y);
+public:
+    std::size_t query(int x, int y, std::size_t radius, std::vector<std::size_t>& out) const override;
+    std::size_t size() const override;
+    std::size_t depth() const;
+private:
+    std::uint32_t build(const std::vector<int>& x, const std::vector<int>& y, std::size_t begin, std::size_t end);
+};
+
+#endif //KD_TREE_H
\ No newline at end of file
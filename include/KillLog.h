@@ -0,0 +1,83 @@
+#ifndef KILL_LOG_H
+#define KILL_LOG_H
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+#include "Observer.h"
+
+// Binary columnar kill log.
+//
+// Layout: a header with a dictionary of type names, then self-contained
+// chunks of up to CHUNK events. A chunk header carries a zone map (round
+// range, victim bounding box, killer and victim type masks) and the encoded
+// length of every column, so readers can skip chunks without decoding them.
+// Types registered after the log was opened are appended to the dictionary
+// by the first chunk that follows. Each column is delta encoded, zigzag
+// mapped and written as LEB128 varints.
+class KillLog final
+{
+public:
+    static constexpr char MAGIC[8] = {'L', 'A', 'B', '6', 'K', 'L', 'O', 'G'};
+    static constexpr std::uint32_t VERSION = 2;
+    static constexpr size_t CHUNK = 4096;
+};
+
+// Buffers events and writes a chunk when it is full and at every flush, so
+// the file is complete at round boundaries.
+class KillLogObserver final: public IObserver
+{
+private:
+    std::ofstream file;
+    std::vector<KillEvent> pending;
+    size_t written_types = 0;
+public:
+    explicit KillLogObserver(const std::string& path);
+    ~KillLogObserver() override;
+public:
+    void on_kill(const KillEvent& event) override;
+    void flush() override;
+private:
+    void write_chunk();
+};
+
+// Inclusive bounds on round and victim position plus type masks.
+struct KillLogFilter
+{
+    std::uint32_t first_round = 0;
+    std::uint32_t last_round = UINT32_MAX;
+    int min_x = INT_MIN;
+    int max_x = INT_MAX;
+    int min_y = INT_MIN;
+    int max_y = INT_MAX;
+    std::uint64_t killers = ~std::uint64_t(0);
+    std::uint64_t victims = ~std::uint64_t(0);
+
+    bool matches(const KillEvent& event) const;
+};
+
+// Walks a memory-mapped kill log one chunk at a time. The whole dictionary,
+// including the types added by chunks, is registered on construction.
+class KillLogReader final
+{
+private:
+    MappedFile mapping;
+    std::vector<NPCType> types;
+    size_t header_types = 0;
+    size_t first_chunk = 0;
+    size_t chunks = 0;
+public:
+    explicit KillLogReader(const std::string& filename);
+public:
+    // Calls visit for every matching event; returns the number of chunks decoded.
+    size_t scan(const KillLogFilter& filter, const std::function<void(const KillEvent&)>& visit) const;
+    size_t chunk_count() const;
+};
+
+#endif //KILL_LOG_H
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef KILL_TABLE_H
+#define KILL_TABLE_H
+
+#include <array>
+#include <cstdint>
+#include "NPC.h"
+#include "NPCType.h"
+#include "NPCTypeList.h"
+
+// Attacker x defender kill rules. Row a holds one bit per defender type that
+// an attacker of type a kills on contact, taken from the VICTIMS of each class
+// in NPCTypeList. Types registered at runtime have no built-in rules; see
+// RuleTable.
+class KillTable final
+{
+private:
+    static constexpr std::array<std::uint64_t, NPC_TYPE_COUNT> rows = npc_type_list::victim_rows(NPCTypeList{});
+public:
+    static constexpr bool can_kill(NPCType attacker, NPCType defender)
+    {
+        return static_cast<unsigned>(attacker) < NPC_TYPE_COUNT && static_cast<unsigned>(defender) < NPC_TYPE_COUNT
+               && ((rows[static_cast<unsigned>(attacker)] >> static_cast<unsigned>(defender)) & 1);
+    }
+
+    static constexpr std::uint64_t victims_of(NPCType attacker)
+    {
+        return static_cast<unsigned>(attacker) < NPC_TYPE_COUNT ? rows[static_cast<unsigned>(attacker)] : 0;
+    }
+};
+
+#endif //KILL_TABLE_H
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file.
+class MappedFile final
+{
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+public:
+    const char* data() const;
+    size_t size() const;
+    std::string_view view() const;
+};
+
+#endif //MAPPED_FILE_H
\ No newline at end of file
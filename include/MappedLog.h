@@ -0,0 +1,76 @@
+#ifndef MAPPED_LOG_H
+#define MAPPED_LOG_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Append-only file written through a shared memory mapping. The file is
+// preallocated CHUNK bytes at a time and only the chunk being written is
+// mapped, so an append is a copy into the page cache. sync() writes the dirty
+// pages back. The file is trimmed to what was written when it is rotated or
+// closed; until then it ends in zeros, which are skipped when a log left
+// behind by a crash is reopened. The file is locked while it is open; a
+// second MappedLog on the same path throws std::runtime_error, while a file
+// that cannot be opened at all throws std::invalid_argument.
+class MappedLog final
+{
+public:
+    static constexpr size_t CHUNK = 1 << 22;
+private:
+    std::string path;
+    int fd = -1;
+    char* window = nullptr;
+    size_t base = 0;
+    size_t used = 0;
+    size_t rotations = 0;
+public:
+    // Appends to the file at path, creating it if needed.
+    explicit MappedLog(const std::string& path);
+    ~MappedLog();
+    MappedLog(const MappedLog&) = delete;
+    MappedLog& operator=(const MappedLog&) = delete;
+public:
+    MappedLog& operator<<(std::string_view text)
+    {
+        if (CHUNK - used < text.size())
+        {
+            append_slow(text);
+            return *this;
+        }
+        std::memcpy(window + used, text.data(), text.size());
+        used += text.size();
+        return *this;
+    }
+
+    MappedLog& operator<<(char c)
+    {
+        return *this << std::string_view(&c, 1);
+    }
+
+    template<typename T> requires std::is_integral_v<T>
+    MappedLog& operator<<(T value)
+    {
+        char digits[24];
+        return *this << std::string_view(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr - digits);
+    }
+
+    void sync();
+    // Closes the current file as path.N, N being the first unused number
+    // from 1, and starts an empty one.
+    void rotate();
+public:
+    size_t size() const;
+    const std::string& get_path() const;
+private:
+    void open_file();
+    size_t logical_size() const;
+    void close_file();
+    void map_chunk(size_t offset);
+    void append_slow(std::string_view text);
+};
+
+#endif //MAPPED_LOG_H
\ No newline at end of file
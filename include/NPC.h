@@ -1,7 +1,10 @@
 #ifndef NPC_H
 #define NPC_H
 
-#include <string>
+#include <cstdint>
+#include <string_view>
+#include "NPCType.h"
+#include "NPCTypeList.h"
 
 class INPCVisitor;
 
@@ -17,39 +20,71 @@ public:
 public:
     virtual void accept(INPCVisitor& visitor) = 0;
 public:
-    virtual std::string get_type() const = 0;
+    std::string_view get_type() const;
+    virtual NPCType get_type_id() const = 0;
 public:
     bool is_close(const NPC& other, size_t distance) const;
+    static bool is_close(int x1, int y1, int x2, int y2, size_t distance);
+    static unsigned long long squared_distance(int x1, int y1, int x2, int y2);
+    static unsigned long long squared_radius(size_t distance);
 };
 
 class Dragon final: public NPC
 {
+public:
+    static constexpr NPCType TYPE_ID = NPCType::Dragon;
+    static constexpr std::string_view NAME = "Dragon";
+    static constexpr std::uint64_t VICTIMS = type_mask(NPCType::Knight);
 public:
     Dragon(int x, int y);
     ~Dragon() override = default;
 
     void accept(INPCVisitor& visitor) override;
-    std::string get_type() const override;
+    NPCType get_type_id() const override;
 };
 
 class Frog final: public NPC
 {
+public:
+    static constexpr NPCType TYPE_ID = NPCType::Frog;
+    static constexpr std::string_view NAME = "Frog";
+    static constexpr std::uint64_t VICTIMS = type_mask(NPCType::Dragon) | type_mask(NPCType::Frog) | type_mask(NPCType::Knight);
 public:
     Frog(int x, int y);
     ~Frog() override = default;
 
     void accept(INPCVisitor& visitor) override;
-    std::string get_type() const override;
+    NPCType get_type_id() const override;
 };
 
 class Knight final: public NPC
 {
+public:
+    static constexpr NPCType TYPE_ID = NPCType::Knight;
+    static constexpr std::string_view NAME = "Knight";
+    static constexpr std::uint64_t VICTIMS = type_mask(NPCType::Dragon);
 public:
     Knight(int x, int y);
     ~Knight() override = default;
 
     void accept(INPCVisitor& visitor) override;
-    std::string get_type() const override;
+    NPCType get_type_id() const override;
+};
+
+// Any type registered at runtime through TypeRegistry::add. Its kill rules
+// come from the arena's RuleTable rather than from a VICTIMS constant.
+class CustomNPC final: public NPC
+{
+private:
+    NPCType type;
+public:
+    CustomNPC(NPCType type, int x, int y);
+    ~CustomNPC() override = default;
+
+    void accept(INPCVisitor& visitor) override;
+    NPCType get_type_id() const override;
 };
 
+static_assert(npc_type_list::in_type_order(NPCTypeList{}), "NPCTypeList must follow NPCType order");
+
 #endif //NPC_H
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef NPC_POOL_H
+#define NPC_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+// Slab memory for NPC objects. Each allocated type gets its own slab of
+// equally sized blocks carved from large chunks, with freed blocks reused.
+// Allocators share ownership of the slab state, so release() can drop every
+// chunk at once while objects handed out earlier stay valid until they die.
+class NPCPool final
+{
+public:
+    class State final
+    {
+    private:
+        struct Slab
+        {
+            std::type_index type;
+            size_t block_size;
+            size_t next_chunk_blocks;
+            char* cursor;
+            char* limit;
+            void* free_list;
+        };
+
+        std::mutex mutex;
+        std::vector<Slab> slabs;
+        std::vector<std::unique_ptr<char[]>> chunks;
+        size_t allocation_count = 0;
+    public:
+        void* allocate(std::type_index type, size_t size, size_t alignment);
+        void deallocate(std::type_index type, void* block);
+        size_t allocations();
+        size_t upstream_allocations();
+    private:
+        Slab& slab_for(std::type_index type, size_t size, size_t alignment);
+    };
+
+    template<typename T>
+    class Allocator
+    {
+    private:
+        template<typename> friend class Allocator;
+        std::shared_ptr<State> state;
+    public:
+        using value_type = T;
+
+        explicit Allocator(std::shared_ptr<State> state) : state(std::move(state)) {}
+
+        template<typename U>
+        Allocator(const Allocator<U>& other) : state(other.state) {}
+
+        T* allocate(size_t n)
+        {
+            if (n != 1)
+            {
+                return std::allocator<T>().allocate(n);
+            }
+            return static_cast<T*>(state->allocate(typeid(T), sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* block, size_t n)
+        {
+            if (n != 1)
+            {
+                std::allocator<T>().deallocate(block, n);
+                return;
+            }
+            state->deallocate(typeid(T), block);
+        }
+
+        template<typename U>
+        bool operator==(const Allocator<U>& other) const
+        {
+            return state == other.state;
+        }
+    };
+private:
+    std::shared_ptr<State> state = std::make_shared<State>();
+public:
+    template<typename T, typename... Args>
+    std::shared_ptr<T> make(Args&&... args)
+    {
+        return std::allocate_shared<T>(Allocator<T>(state), std::forward<Args>(args)...);
+    }
+public:
+    void release();
+    size_t allocations() const;
+    size_t upstream_allocations() const;
+};
+
+#endif //NPC_POOL_H
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef NPC_STORE_H
+#define NPC_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "NPC.h"
+#include "NPCPool.h"
+#include "NPCType.h"
+
+// Identifies an NPC independently of where its record currently lives in the store.
+struct NPCHandle
+{
+    std::uint32_t id;
+
+    bool operator==(const NPCHandle&) const = default;
+};
+
+// Copy of one NPC, live or buried, for reporting.
+struct NPCRecord
+{
+    NPCHandle handle;
+    NPCType type;
+    int x;
+    int y;
+    bool is_alive;
+};
+
+// Structure-of-arrays population: coordinates and types live in contiguous
+// columns and liveness in a bitset, so battle walks plain arrays instead of
+// chasing one heap object per NPC.
+// compact() moves dead NPCs out of the columns into a graveyard, keeping the
+// survivors in their relative order; handles stay valid across it.
+class NPCStore final
+{
+public:
+    static constexpr std::uint32_t NO_INDEX = 0xFFFFFFFFu;
+private:
+    std::vector<int> xs;
+    std::vector<int> ys;
+    std::vector<NPCType> types;
+    std::vector<std::uint64_t> alive;
+    std::vector<std::uint32_t> handles;
+    std::vector<std::uint32_t> indices;
+    size_t alive_total = 0;
+    std::vector<NPCRecord> graveyard;
+public:
+    NPCHandle add(NPCType type, int x, int y);
+    // Appends columns in one go and returns the handle of the first new NPC;
+    // the rest follow with consecutive ids. Without alive bits every new NPC
+    // is alive.
+    NPCHandle append(std::span<const int> x, std::span<const int> y, std::span<const NPCType> type,
+                std::span<const std::uint64_t> alive_bits = {});
+    void reserve(size_t count);
+    void clear();
+public:
+    size_t size() const;
+    size_t alive_count() const;
+public:
+    int x(size_t index) const;
+    int y(size_t index) const;
+    NPCType type(size_t index) const;
+    bool is_alive(size_t index) const;
+    void kill(size_t index);
+public:
+    // Returns the new index of every old index, NO_INDEX for buried ones.
+    std::vector<std::uint32_t> compact();
+    size_t dead_count() const;
+    const std::vector<NPCRecord>& get_graveyard() const;
+    const std::vector<int>& get_xs() const;
+    const std::vector<int>& get_ys() const;
+    const std::vector<NPCType>& get_types() const;
+    const std::vector<std::uint64_t>& get_alive_bits() const;
+public:
+    NPCHandle handle(size_t index) const;
+    // Throws for handles of NPCs buried by compact().
+    size_t index_of(NPCHandle handle) const;
+    bool is_buried(NPCHandle handle) const;
+    NPCRecord record(NPCHandle handle) const;
+public:
+    std::shared_ptr<NPC> view(size_t index) const;
+    std::shared_ptr<NPC> view(size_t index, NPCPool& pool) const;
+};
+
+#endif //NPC_STORE_H
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef NPC_TYPE_H
+#define NPC_TYPE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Built-in types. Values from NPC_TYPE_COUNT up to MAX_NPC_TYPES are handed
+// out at runtime by TypeRegistry::add for types defined in data files.
+enum class NPCType : std::uint8_t
+{
+    Dragon,
+    Frog,
+    Knight
+};
+
+inline constexpr std::size_t NPC_TYPE_COUNT = 3;
+inline constexpr std::size_t MAX_NPC_TYPES = 64;
+
+constexpr std::uint64_t type_mask(NPCType type)
+{
+    return std::uint64_t(1) << static_cast<unsigned>(type);
+}
+
+#endif //NPC_TYPE_H
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef NPC_TYPE_LIST_H
+#define NPC_TYPE_LIST_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "NPCType.h"
+
+template<typename... Ts>
+struct TypeList
+{
+    static constexpr std::size_t size = sizeof...(Ts);
+};
+
+// Every NPC class, in NPCType order. The visitor interface, the factory, the
+// type names and the kill table are all generated from this list; each class
+// supplies its TYPE_ID, NAME and VICTIMS.
+using NPCTypeList = TypeList<class Dragon, class Frog, class Knight>;
+
+static_assert(NPCTypeList::size == NPC_TYPE_COUNT, "NPCTypeList and NPCType disagree");
+
+namespace npc_type_list
+{
+    template<typename First, typename... Rest>
+    First first(TypeList<First, Rest...>);
+
+    template<typename F, typename... Ts>
+    decltype(auto) visit(NPCType type, F&& f, TypeList<Ts...> list)
+    {
+        using Result = decltype(f(std::type_identity<decltype(first(list))>{}));
+        if constexpr (std::is_void_v<Result>)
+        {
+            const bool found = ((type == Ts::TYPE_ID && (f(std::type_identity<Ts>{}), true)) || ...);
+            if (!found)
+            {
+                throw std::invalid_argument("Unknown type");
+            }
+        }
+        else
+        {
+            Result result{};
+            const bool found = ((type == Ts::TYPE_ID && (result = f(std::type_identity<Ts>{}), true)) || ...);
+            if (!found)
+            {
+                throw std::invalid_argument("Unknown type");
+            }
+            return result;
+        }
+    }
+
+    template<typename... Ts>
+    constexpr std::array<std::uint64_t, NPC_TYPE_COUNT> victim_rows(TypeList<Ts...>)
+    {
+        std::array<std::uint64_t, NPC_TYPE_COUNT> rows{};
+        ((rows[static_cast<std::size_t>(Ts::TYPE_ID)] = Ts::VICTIMS), ...);
+        return rows;
+    }
+
+    template<typename... Ts>
+    constexpr bool in_type_order(TypeList<Ts...>)
+    {
+        std::size_t index = 0;
+        return ((static_cast<std::size_t>(Ts::TYPE_ID) == index++) && ...);
+    }
+}
+
+// Calls f(std::type_identity<T>{}) for the NPC class T whose TYPE_ID is type.
+// The comparisons are unrolled at compile time, so f is inlined into each branch.
+template<typename F>
+decltype(auto) visit_npc_type(NPCType type, F&& f)
+{
+    return npc_type_list::visit(type, std::forward<F>(f), NPCTypeList{});
+}
+
+#endif //NPC_TYPE_LIST_H
\ No newline at end of file
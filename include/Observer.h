@@ -1,21 +1,66 @@
 #ifndef OBSERVER_H
 #define OBSERVER_H
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
 #include <fstream>
+#include <iostream>
+#include "MappedLog.h"
+#include "NPCType.h"
 
+// Arena::battle fills in everything; ids are NPCHandle ids, which survive
+// compaction, and positions are those at the time of the kill.
+struct KillEvent
+{
+    NPCType killer;
+    NPCType victim;
+    std::uint32_t round = 0;
+    std::uint64_t radius = 0;
+    std::uint32_t killer_id = 0;
+    std::uint32_t victim_id = 0;
+    int killer_x = 0;
+    int killer_y = 0;
+    int victim_x = 0;
+    int victim_y = 0;
+};
+
+// Arena::battle brackets every round with on_round_begin and on_round_end
+// and hands over the kills of the round in between through on_round, in kill
+// order. A round's kills may arrive in several spans, and a span is only
+// valid during the call.
 class IObserver
 {
 public:
-    virtual void msg_kill(const std::string& killer, const std::string& victim) = 0;
+    virtual void on_round_begin(std::uint32_t round, std::uint64_t radius);
+    // The default forwards every event to on_kill.
+    virtual void on_round(std::span<const KillEvent> events);
+    // The default calls flush().
+    virtual void on_round_end(std::uint32_t round);
+public:
+    // Called for every kill by the default on_round. The default forwards to
+    // msg_kill with the type names, so observers written against the string
+    // interface keep working.
+    virtual void on_kill(const KillEvent& event);
+    virtual void msg_kill(const std::string& killer, const std::string& victim);
+    // Pushes out buffered output.
+    virtual void flush();
 
     virtual ~IObserver() = default;
 };
 
 class IConsoleObserver final: public IObserver
 {
+private:
+    std::ostream& out;
+public:
+    explicit IConsoleObserver(std::ostream& out = std::cout);
 public:
-    void msg_kill(const std::string& killer, const std::string& victim) override;
+    void on_round(std::span<const KillEvent> events) override;
+    void on_kill(const KillEvent& event) override;
+    void flush() override;
 };
 
 class FileObserver final: public IObserver
@@ -23,10 +68,42 @@ class FileObserver final: public IObserver
 private:
     std::ofstream file;
 public:
-    FileObserver();
+    explicit FileObserver(const std::string& path = "../logs.txt");
     ~FileObserver() override;
 public:
-    void msg_kill(const std::string& killer, const std::string& victim) override;
+    void on_round(std::span<const KillEvent> events) override;
+    void on_kill(const KillEvent& event) override;
+    void flush() override;
+};
+
+// Text kill log written through a MappedLog, in the same format as
+// FileObserver. The file is rotated after the line that takes it to
+// rotate_bytes (0 never rotates) and synced at the end of a round once
+// sync_interval has passed since the last sync; 0 syncs every round, which
+// costs an fdatasync per round. Like FileObserver, a log that cannot be opened is skipped, but a
+// log already held by another writer is an error.
+class MappedLogObserver final: public IObserver
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::unique_ptr<MappedLog> log;
+    size_t rotate_bytes;
+    std::chrono::milliseconds sync_interval;
+    Clock::time_point last_sync;
+public:
+    explicit MappedLogObserver(const std::string& path, size_t rotate_bytes = 0,
+                               std::chrono::milliseconds sync_interval = std::chrono::seconds(1));
+public:
+    void on_round(std::span<const KillEvent> events) override;
+    void on_round_end(std::uint32_t round) override;
+    void on_kill(const KillEvent& event) override;
+    // Syncs regardless of the interval.
+    void flush() override;
+public:
+    bool is_open() const;
+private:
+    void write(const KillEvent& event);
 };
 
 #endif //OBSERVER_H
\ No newline at end of file
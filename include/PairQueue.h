@@ -0,0 +1,45 @@
+#ifndef PAIR_QUEUE_H
+#define PAIR_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "RadiusSchedule.h"
+#include "SpatialIndex.h"
+
+// Attacker/defender pairs bucketed by the first round whose radius reaches them.
+// A pair's distance never changes during a battle, so once it has been tested
+// with both sides alive later rounds cannot produce a different outcome; each
+// round therefore only has to look at the pairs that newly came into range.
+// Inside a band pairs are ordered by attacker, then by defender, which is the
+// order of the full scan.
+struct NPCPair
+{
+    std::uint32_t attacker;
+    std::uint32_t defender;
+};
+
+class PairQueue final
+{
+private:
+    std::vector<size_t> band_start;
+    std::vector<NPCPair> pairs;
+    std::uint64_t tests = 0;
+public:
+    PairQueue(const std::vector<int>& xs, const std::vector<int>& ys, const RadiusSchedule& schedule,
+              SpatialIndexKind index = SpatialIndexKind::Grid);
+public:
+    std::span<const NPCPair> band(size_t round) const;
+    size_t rounds() const;
+    size_t size() const;
+    // Candidate distance tests spent while building the queue.
+    std::uint64_t distance_tests() const;
+public:
+    // Rewrites the bands from first_round on through an index remap produced
+    // by NPCStore::compact(), dropping pairs with a buried side. Earlier bands
+    // are emptied. The remap is monotonic, so band order is preserved.
+    void compact(std::span<const std::uint32_t> remap, size_t first_round);
+};
+
+#endif //PAIR_QUEUE_H
\ No newline at end of file
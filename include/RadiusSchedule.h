@@ -0,0 +1,24 @@
+#ifndef RADIUS_SCHEDULE_H
+#define RADIUS_SCHEDULE_H
+
+#include <cstddef>
+#include <vector>
+
+// Sequence of attack radii used by Arena::battle, one per round.
+// Radii must never decrease.
+class RadiusSchedule final
+{
+private:
+    std::vector<size_t> radii;
+public:
+    explicit RadiusSchedule(std::vector<size_t> radii);
+public:
+    static RadiusSchedule linear(size_t distance, size_t step);
+public:
+    size_t rounds() const;
+    size_t radius(size_t round) const;
+    size_t max_radius() const;
+    const std::vector<size_t>& get_radii() const;
+};
+
+#endif //RADIUS_SCHEDULE_H
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef RULE_TABLE_H
+#define RULE_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "NPCType.h"
+
+// Attacker x defender kill rules as one victim bitmask per attacker type,
+// covering every type TypeRegistry can hand out. builtin() mirrors KillTable;
+// parse() compiles a rules file:
+//
+//     # comment
+//     types Dragon Frog Knight Elf
+//     Dragon 0 0 1 0
+//     Elf    1 0 0 0
+//
+// The types line names the matrix columns; each following row lists an
+// attacker and one 0/1 flag per column. Attackers without a row kill nothing.
+// Names not yet known are registered with TypeRegistry::add.
+class RuleTable final
+{
+private:
+    std::array<std::uint64_t, MAX_NPC_TYPES> rows{};
+public:
+    static const RuleTable& builtin();
+    static RuleTable parse(std::string_view text);
+    static RuleTable load(const std::string& filename);
+public:
+    bool can_kill(NPCType attacker, NPCType defender) const
+    {
+        const auto a = static_cast<std::size_t>(attacker);
+        const auto d = static_cast<std::size_t>(defender);
+        return a < MAX_NPC_TYPES && d < MAX_NPC_TYPES && ((rows[a] >> d) & 1);
+    }
+
+    std::uint64_t victims_of(NPCType attacker) const;
+    void set(NPCType attacker, NPCType defender, bool kills);
+};
+
+#endif //RULE_TABLE_H
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include "NPCStore.h"
+
+// Versioned binary arena snapshot.
+//
+// Layout: a fixed header, a dictionary of type names, then the x, y, type and
+// alive columns, each starting at an 8-byte aligned offset recorded in the
+// header. Type codes index the dictionary, so snapshots do not depend on the
+// numbering of types in the running program.
+class Snapshot final
+{
+public:
+    static constexpr char MAGIC[8] = {'L', 'A', 'B', '6', 'S', 'N', 'A', 'P'};
+    static constexpr std::uint32_t VERSION = 1;
+public:
+    static void write(const NPCStore& store, const std::string& filename);
+    static void read(const std::string& filename, NPCStore& store);
+    static bool is_snapshot(const std::string& filename);
+};
+
+#endif //SNAPSHOT_H
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "SpatialIndex.h"
+
+// Bucket grid over NPC positions. Points are grouped by cell so that a radius
+// query only touches the cells the circle can reach. When the bounding box is
+// too large to allocate a cell per square, cells are kept in a hash map
+// keyed by cell coordinates instead.
+class SpatialGrid final: public ISpatialIndex
+{
+public:
+    enum class Layout
+    {
+        Dense,
+        Hashed
+    };
+private:
+    Layout layout = Layout::Dense;
+    std::int64_t cell_size;
+    std::int64_t min_cx = 0;
+    std::int64_t min_cy = 0;
+    std::int64_t max_cx = -1;
+    std::int64_t max_cy = -1;
+    std::int64_t cols = 0;
+    std::int64_t rows = 0;
+    std::vector<std::size_t> cell_start;
+    std::unordered_map<std::uint64_t, std::pair<std::size_t, std::size_t>> cells;
+    std::vector<std::size_t> ids;
+    std::vector<int> xs;
+    std::vector<int> ys;
+public:
+    SpatialGrid(const std::vector<int>& x, const std::vector<int>& y, std::int64_t cell_size);
+public:
+    std::size_t query(int x, int y, std::size_t radius, std::vector<std::size_t>& out) const override;
+    std::size_t size() const override;
+public:
+    Layout get_layout() const;
+private:
+    std::int64_t cell_of(int coordinate) const;
+    std::size_t scan(std::size_t begin, std::size_t end, int x, int y, std::size_t radius,
+                     std::vector<std::size_t>& out) const;
+    static std::uint64_t key_of(std::int64_t cx, std::int64_t cy);
+};
+
+#endif //SPATIAL_GRID_H
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class SpatialIndexKind
+{
+    BruteForce,
+    Grid,
+    KdTree
+};
+
+// Radius queries over a fixed set of points identified by their position in
+// the coordinate arrays the index was built from.
+class ISpatialIndex
+{
+public:
+    // Appends the ids of all points within radius of (x, y), inclusive, in no
+    // particular order. Returns the number of candidates whose distance was tested.
+    virtual std::size_t query(int x, int y, std::size_t radius, std::vector<std::size_t>& out) const = 0;
+    virtual std::size_t size() const = 0;
+
+    virtual ~ISpatialIndex() = default;
+};
+
+// Tests every point; the reference the other indexes are checked against.
+class BruteForceIndex final: public ISpatialIndex
+{
+private:
+    std::vector<int> xs;
+    std::vector<int> ys;
+public:
+    BruteForceIndex(const std::vector<int>& x, const std::vector<int>& y);
+public:
+    std::size_t query(int x, int y, std::size_t radius, std::vector<std::size_t>& out) const override;
+    std::size_t size() const override;
+};
+
+class SpatialIndex final
+{
+public:
+    // radius is the largest radius the index will typically be queried with;
+    // only the grid uses it, to size its cells.
+    static std::unique_ptr<ISpatialIndex> build(SpatialIndexKind kind, const std::vector<int>& x,
+                                                const std::vector<int>& y, std::size_t radius);
+};
+
+#endif //SPATIAL_INDEX_H
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef TEXT_LOADER_H
+#define TEXT_LOADER_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "NPCStore.h"
+
+class ParseError final: public std::invalid_argument
+{
+private:
+    size_t line_number;
+public:
+    ParseError(size_t line, const std::string& reason);
+public:
+    size_t line() const;
+};
+
+// Reader for the "type x y" text format. The file is memory-mapped, lines are
+// counted up front so the columns are reserved once, and numbers are parsed
+// with std::from_chars. The store is only replaced once the whole file parsed.
+class TextLoader final
+{
+public:
+    static void read(const std::string& filename, NPCStore& store);
+    static void parse(std::string_view text, NPCStore& store);
+};
+
+#endif //TEXT_LOADER_H
\ No newline at end of file
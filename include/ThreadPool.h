@@ -0,0 +1,45 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run indexed tasks. The calling thread takes
+// part in the work, so a pool of size 1 runs everything inline.
+class ThreadPool final
+{
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t job_size = 0;
+    size_t generation = 0;
+    size_t busy = 0;
+    std::atomic<size_t> next{0};
+    std::exception_ptr failure;
+    bool stopping = false;
+public:
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+public:
+    // Runs task(0) .. task(count - 1) and returns once all of them finished.
+    // If a task throws, the tasks not yet started are skipped and the first
+    // exception is rethrown on the calling thread once every worker is idle.
+    void run(size_t count, const std::function<void(size_t)>& task);
+    size_t size() const;
+private:
+    void work(const std::function<void(size_t)>& task, size_t count);
+    void worker_loop();
+};
+
+#endif //THREAD_POOL_H
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef TYPE_REGISTRY_H
+#define TYPE_REGISTRY_H
+
+#include <cstddef>
+#include <string_view>
+#include "NPCType.h"
+
+// Interned NPC type names. The built-in types from NPCTypeList come first;
+// data files can register more with add(). Names are stored once and never
+// move, so callers can keep the returned views. Lookup by name is a single
+// hash probe; lookup by type is an array index. Names are made of letters,
+// digits, '_' and '-', so they can go into any output format unescaped.
+class TypeRegistry final
+{
+public:
+    static std::string_view name(NPCType type);
+    static NPCType find(std::string_view name);
+    // Returns the type registered under name, registering it first if needed.
+    static NPCType add(std::string_view name);
+    static bool contains(std::string_view name);
+    static bool is_valid_name(std::string_view name);
+    static std::size_t count();
+};
+
+#endif //TYPE_REGISTRY_H
\ No newline at end of file
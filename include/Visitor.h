@@ -5,31 +5,92 @@
 #include <vector>
 #include "Observer.h"
 #include "NPC.h"
+#include "NPCTypeList.h"
+#include "RuleTable.h"
 
-class INPCVisitor
+template<typename T>
+class NPCVisitorFor
 {
 public:
-    virtual void try_to_kill(Dragon& dragon) = 0;
-    virtual void try_to_kill(Frog& frog) = 0;
-    virtual void try_to_kill(Knight& knight) = 0;
+    virtual void try_to_kill(T& npc) = 0;
 
-    virtual ~INPCVisitor() = default;
+    virtual ~NPCVisitorFor() = default;
 };
 
-class BattleVisitor final: public INPCVisitor
+template<typename List>
+class NPCVisitorOf;
+
+template<typename... Ts>
+class NPCVisitorOf<TypeList<Ts...>> : public NPCVisitorFor<Ts>...
+{
+public:
+    using NPCVisitorFor<Ts>::try_to_kill...;
+};
+
+// One pure try_to_kill overload per class in NPCTypeList, plus CustomNPC for
+// the types registered at runtime.
+class INPCVisitor : public NPCVisitorOf<NPCTypeList>, public NPCVisitorFor<CustomNPC>
+{
+public:
+    using NPCVisitorOf<NPCTypeList>::try_to_kill;
+    using NPCVisitorFor<CustomNPC>::try_to_kill;
+};
+
+// Implements every try_to_kill overload by forwarding to Impl::visit, which is
+// a template over the defender class, so each override is resolved statically.
+template<typename Impl, typename... Ts>
+class NPCVisitorChain : public INPCVisitor
+{
+public:
+    using INPCVisitor::try_to_kill;
+};
+
+template<typename Impl, typename T, typename... Rest>
+class NPCVisitorChain<Impl, T, Rest...> : public NPCVisitorChain<Impl, Rest...>
+{
+public:
+    using NPCVisitorChain<Impl, Rest...>::try_to_kill;
+
+    void try_to_kill(T& npc) override
+    {
+        static_cast<Impl&>(*this).visit(npc);
+    }
+};
+
+template<typename Impl, typename List>
+struct NPCVisitorBaseOf;
+
+template<typename Impl, typename... Ts>
+struct NPCVisitorBaseOf<Impl, TypeList<Ts...>>
+{
+    using type = NPCVisitorChain<Impl, Ts..., CustomNPC>;
+};
+
+template<typename Impl>
+using NPCVisitor = typename NPCVisitorBaseOf<Impl, NPCTypeList>::type;
+
+class BattleVisitor final: public NPCVisitor<BattleVisitor>
 {
 private:
     std::shared_ptr<NPC> attacker;
     std::vector<std::shared_ptr<IObserver>>& observers;
+    const RuleTable& rules;
 public:
-    BattleVisitor(std::shared_ptr<NPC> attacker, std::vector<std::shared_ptr<IObserver>>& observers);
+    BattleVisitor(std::shared_ptr<NPC> attacker, std::vector<std::shared_ptr<IObserver>>& observers,
+                  const RuleTable& rules = RuleTable::builtin());
     ~BattleVisitor() override = default;
 public:
-    void try_to_kill(Dragon& defender) override;
-    void try_to_kill(Frog& defender) override;
-    void try_to_kill(Knight& defender) override;
+    template<typename Defender>
+    void visit(Defender& defender)
+    {
+        if (rules.can_kill(attacker->get_type_id(), defender.get_type_id()))
+        {
+            defender.is_alive = false;
+            notify(defender.get_type_id());
+        }
+    }
 public:
-    void notify(const std::string& victim_type) const;
+    void notify(NPCType victim_type) const;
 };
 
 #endif //VISITOR_H
\ No newline at end of file
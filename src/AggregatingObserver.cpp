@@ -0,0 +1,145 @@
+#include "AggregatingObserver.h"
+
+#include <stdexcept>
+#include "TypeRegistry.h"
+
+AggregatingObserver::AggregatingObserver() : AggregatingObserver(TypeRegistry::count()) {}
+
+AggregatingObserver::AggregatingObserver(size_t types) :
+                                        types(types),
+                                        totals(std::make_unique<std::atomic<std::uint64_t>[]>(types * types)),
+                                        rounds(std::make_unique<std::atomic<std::uint64_t>[]>(HISTORY * types * types)),
+                                        slot_rounds(std::make_unique<std::atomic<std::uint64_t>[]>(HISTORY))
+{
+    if (types == 0 || types > MAX_NPC_TYPES)
+    {
+        throw std::invalid_argument("Invalid number of types");
+    }
+    reset();
+}
+
+void AggregatingObserver::on_round(std::span<const KillEvent> events)
+{
+    for (const KillEvent& event : events)
+    {
+        on_kill(event);
+    }
+}
+
+void AggregatingObserver::on_kill(const KillEvent& event)
+{
+    const size_t index = cell(event.killer, event.victim);
+    if (index == types * types)
+    {
+        untracked.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // The slot of a new round is cleared before it is tagged, so a reader
+    // that sees the tag both before and after reading a counter knows the
+    // counter belongs to that round.
+    const std::uint64_t tag = std::uint64_t(event.round) + 1;
+    const size_t slot = event.round % HISTORY;
+    std::atomic<std::uint64_t>* counters = rounds.get() + slot * types * types;
+    if (slot_rounds[slot].load(std::memory_order_relaxed) != tag)
+    {
+        slot_rounds[slot].store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t k = 0; k < types * types; ++k)
+        {
+            counters[k].store(0, std::memory_order_relaxed);
+        }
+        slot_rounds[slot].store(tag, std::memory_order_release);
+    }
+
+    counters[index].fetch_add(1, std::memory_order_relaxed);
+    totals[index].fetch_add(1, std::memory_order_relaxed);
+    kill_total.fetch_add(1, std::memory_order_relaxed);
+    if (last_round.load(std::memory_order_relaxed) < tag)
+    {
+        last_round.store(tag, std::memory_order_relaxed);
+    }
+}
+
+size_t AggregatingObserver::type_count() const
+{
+    return types;
+}
+
+std::uint64_t AggregatingObserver::total() const
+{
+    return kill_total.load(std::memory_order_relaxed);
+}
+
+std::uint64_t AggregatingObserver::total(NPCType killer, NPCType victim) const
+{
+    const size_t index = cell(killer, victim);
+    return index == types * types ? 0 : totals[index].load(std::memory_order_relaxed);
+}
+
+std::uint64_t AggregatingObserver::in_round(size_t round, NPCType killer, NPCType victim) const
+{
+    const size_t index = cell(killer, victim);
+    if (index == types * types)
+    {
+        return 0;
+    }
+    const std::uint64_t tag = std::uint64_t(round) + 1;
+    const size_t slot = round % HISTORY;
+    if (slot_rounds[slot].load(std::memory_order_acquire) != tag)
+    {
+        return 0;
+    }
+    const std::uint64_t count = rounds[slot * types * types + index].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot_rounds[slot].load(std::memory_order_relaxed) == tag ? count : 0;
+}
+
+std::uint64_t AggregatingObserver::in_round(size_t round) const
+{
+    std::uint64_t count = 0;
+    for (size_t killer = 0; killer < types; ++killer)
+    {
+        for (size_t victim = 0; victim < types; ++victim)
+        {
+            count += in_round(round, static_cast<NPCType>(killer), static_cast<NPCType>(victim));
+        }
+    }
+    return count;
+}
+
+std::uint64_t AggregatingObserver::rounds_seen() const
+{
+    return last_round.load(std::memory_order_relaxed);
+}
+
+std::uint64_t AggregatingObserver::untracked_count() const
+{
+    return untracked.load(std::memory_order_relaxed);
+}
+
+void AggregatingObserver::reset()
+{
+    for (size_t k = 0; k < types * types; ++k)
+    {
+        totals[k].store(0, std::memory_order_relaxed);
+    }
+    for (size_t k = 0; k < HISTORY * types * types; ++k)
+    {
+        rounds[k].store(0, std::memory_order_relaxed);
+    }
+    for (size_t slot = 0; slot < HISTORY; ++slot)
+    {
+        slot_rounds[slot].store(0, std::memory_order_relaxed);
+    }
+    kill_total.store(0, std::memory_order_relaxed);
+    untracked.store(0, std::memory_order_relaxed);
+    last_round.store(0, std::memory_order_release);
+}
+
+size_t AggregatingObserver::cell(NPCType killer, NPCType victim) const
+{
+    const auto k = static_cast<size_t>(killer);
+    const auto v = static_cast<size_t>(victim);
+    return k < types && v < types ? k * types + v : types * types;
+}
\ No newline at end of file
@@ -1,102 +1,704 @@
 #include "Arena.h"
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
+#include "BufferedWriter.h"
+#include "DenseKernel.h"
 #include "Factory.h"
-#include "Visitor.h"
+#include "KillLog.h"
+#include "Snapshot.h"
+#include "TextLoader.h"
+#include "TypeRegistry.h"
 
-Arena::Arena()
+namespace
 {
-    observers.push_back(std::make_shared<IConsoleObserver>());
-    observers.push_back(std::make_shared<FileObserver>());
+    constexpr size_t SIMULTANEOUS_CHUNK = 4096;
+    // Kills buffered before a round's events are handed to the observers early.
+    constexpr size_t ROUND_EVENTS = 16384;
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_ms(Clock::time_point since)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+    }
+
+    // Region queries have no natural radius, so a grid is sized for about one
+    // NPC per cell.
+    size_t density_radius(const std::vector<int>& xs, const std::vector<int>& ys)
+    {
+        if (xs.empty())
+        {
+            return 0;
+        }
+        const auto [min_x, max_x] = std::minmax_element(xs.begin(), xs.end());
+        const auto [min_y, max_y] = std::minmax_element(ys.begin(), ys.end());
+        const double area = (double(*max_x) - *min_x + 1) * (double(*max_y) - *min_y + 1);
+        return static_cast<size_t>(2 * std::sqrt(area / static_cast<double>(xs.size())));
+    }
+}
+
+Arena::Arena() : Arena(ArenaConfig{}) {}
+
+Arena::Arena(ArenaConfig config) : config(std::move(config)), pool(std::make_unique<ThreadPool>(1))
+{
+    if (this->config.console_log)
+    {
+        observers.push_back(std::make_shared<IConsoleObserver>(*this->config.console));
+    }
+    if (!this->config.log_path.empty())
+    {
+        observers.push_back(std::make_shared<MappedLogObserver>(this->config.log_path, this->config.log_rotate_bytes,
+                                                                this->config.log_sync_interval));
+    }
+    if (!this->config.kill_log_path.empty())
+    {
+        observers.push_back(std::make_shared<KillLogObserver>(this->config.kill_log_path));
+    }
 }
 
 Arena& Arena::get_instance()
 {
-    static Arena instance;
+    static Arena instance(ArenaConfig{"../logs.txt", "../res.txt"});
     return instance;
 }
 
-void Arena::add_npc(const std::string& type, int x, int y)
+const ArenaConfig& Arena::get_config() const
+{
+    return config;
+}
+
+void Arena::add_observer(std::shared_ptr<IObserver> observer)
+{
+    observers.push_back(std::move(observer));
+    if (pipeline)
+    {
+        set_async_observers(true, pipeline->get_capacity(), pipeline->get_policy());
+    }
+}
+
+void Arena::clear_observers()
+{
+    observers.clear();
+    if (pipeline)
+    {
+        set_async_observers(true, pipeline->get_capacity(), pipeline->get_policy());
+    }
+}
+
+NPCHandle Arena::add_npc(const std::string& type, int x, int y)
+{
+    region_index.reset();
+    return INPCFactory::create_npc(npcs, type, x, y);
+}
+
+NPCHandle Arena::add_npc(NPCType type, int x, int y)
+{
+    TypeRegistry::name(type); // throws for ids that were never registered
+    region_index.reset();
+    return npcs.add(type, x, y);
+}
+
+NPCHandle Arena::add_npcs(std::span<const int> x, std::span<const int> y, std::span<const NPCType> types)
+{
+    const size_t type_count = TypeRegistry::count();
+    for (NPCType type : types)
+    {
+        if (static_cast<size_t>(type) >= type_count)
+        {
+            throw std::invalid_argument("Unknown type");
+        }
+    }
+
+    region_index.reset();
+    return npcs.append(x, y, types);
+}
+
+NPCHandle Arena::add_npcs(const Population& population)
+{
+    return add_npcs(population.x, population.y, population.types);
+}
+
+NPCHandle Arena::populate(const PopulationSpec& spec)
+{
+    return add_npcs(PopulationGenerator::generate(spec, *pool));
+}
+
+std::shared_ptr<NPC> Arena::get_npc(NPCHandle handle) const
 {
-    npcs.push_back(INPCFactory::create_npc(type, x, y));
+    const NPCRecord record = npcs.record(handle);
+    auto npc = INPCFactory::create_npc(record.type, record.x, record.y, npc_pool);
+    npc->is_alive = record.is_alive;
+    return npc;
+}
+
+const NPCStore& Arena::get_npcs() const
+{
+    return npcs;
+}
+
+const NPCPool& Arena::get_npc_pool() const
+{
+    return npc_pool;
+}
+
+void Arena::set_spatial_index(SpatialIndexKind kind)
+{
+    spatial_index = kind;
+    region_index.reset();
+}
+
+SpatialIndexKind Arena::get_spatial_index() const
+{
+    return spatial_index;
+}
+
+std::vector<NPCHandle> Arena::query_region(int x, int y, size_t radius) const
+{
+    if (!region_index)
+    {
+        region_index = SpatialIndex::build(spatial_index, npcs.get_xs(), npcs.get_ys(),
+                                           density_radius(npcs.get_xs(), npcs.get_ys()));
+    }
+
+    std::vector<size_t> found;
+    region_index->query(x, y, radius, found);
+    std::sort(found.begin(), found.end());
+
+    std::vector<NPCHandle> handles;
+    for (size_t index : found)
+    {
+        if (npcs.is_alive(index))
+        {
+            handles.push_back(npcs.handle(index));
+        }
+    }
+    return handles;
 }
 
-void Arena::save_to_file(const std::string& filename) const
+void Arena::save_to_file(const std::string& filename, FileFormat format) const
 {
+    if (format == FileFormat::Binary)
+    {
+        Snapshot::write(npcs, filename);
+        return;
+    }
+
     std::ofstream file(filename);
     if (!file.is_open())
     {
         throw std::invalid_argument("Unable to save data to file");
     }
 
-    for (const auto& npc : npcs)
+    BufferedWriter writer(file);
+    for (size_t i = 0; i < npcs.size(); ++i)
     {
-        if (npc->is_alive)
+        if (npcs.is_alive(i))
         {
-            file << npc->get_type() << ' ' << npc->x << ' ' << npc->y << std::endl;
+            writer << TypeRegistry::name(npcs.type(i)) << ' ' << npcs.x(i) << ' ' << npcs.y(i) << '\n';
         }
     }
 }
 
 void Arena::load_from_file(const std::string& filename)
 {
-    std::ifstream file(filename);
-    if (!file.is_open())
+    region_index.reset();
+    if (Snapshot::is_snapshot(filename))
     {
-        throw std::invalid_argument("Unable to load data from file");
+        Snapshot::read(filename, npcs);
+        return;
     }
+    TextLoader::read(filename, npcs);
+}
 
-    clear_npcs();
-
-    int x;
-    int y;
-    std::string type;
-    while (file >> type >> x >> y)
+void Arena::print_survivors() const
+{
+    BufferedWriter writer(*config.console);
+    for (size_t i = 0; i < npcs.size(); ++i)
     {
-        add_npc(type, x, y);
+        if (npcs.is_alive(i))
+        {
+            writer << TypeRegistry::name(npcs.type(i)) << ' ' << npcs.x(i) << ' ' << npcs.y(i) << '\n';
+        }
     }
 }
 
-void Arena::print_survivors() const
+void Arena::set_survivor_report(SurvivorReport mode, size_t sample)
 {
-    for (const auto& npc : npcs)
+    config.survivor_report = mode;
+    config.survivor_sample = sample;
+}
+
+void Arena::report_survivors(const RoundStats& round,
+                             const std::vector<std::pair<NPCType, size_t>>& alive_by_type) const
+{
+    if (config.survivor_report == SurvivorReport::Full)
     {
-        if (npc->is_alive)
+        print_survivors();
+        return;
+    }
+    if (config.survivor_report != SurvivorReport::Summary && config.survivor_report != SurvivorReport::Sampled)
+    {
+        return;
+    }
+
+    BufferedWriter writer(*config.console);
+    writer << "Round " << round.round << " radius " << round.radius << ':';
+    for (const auto& [type, alive] : alive_by_type)
+    {
+        writer << ' ' << TypeRegistry::name(type) << ' ' << alive;
+    }
+    writer << '\n';
+
+    if (config.survivor_report == SurvivorReport::Sampled && config.survivor_sample != 0)
+    {
+        // Shows the first survivor of each of survivor_sample equal stretches of the store.
+        const size_t sample = config.survivor_sample;
+        for (size_t stretch = 0; stretch < sample; ++stretch)
         {
-            std::cout << npc->get_type() << ' ' << npc->x << ' ' << npc->y << std::endl;
+            const size_t begin = stretch * npcs.size() / sample;
+            const size_t end = (stretch + 1) * npcs.size() / sample;
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (npcs.is_alive(i))
+                {
+                    writer << TypeRegistry::name(npcs.type(i)) << ' ' << npcs.x(i) << ' ' << npcs.y(i) << '\n';
+                    break;
+                }
+            }
         }
     }
 }
 
+void Arena::set_radius_step(size_t step)
+{
+    if (step == 0)
+    {
+        throw std::invalid_argument("Radius step must be positive");
+    }
+    radius_step = step;
+}
+
 void Arena::battle(size_t distance)
 {
-    size_t start_range = 0;
-    while (start_range <= distance)
+    battle(RadiusSchedule::linear(distance, radius_step));
+}
+
+void Arena::battle(const RadiusSchedule& schedule)
+{
+    stats.reset(npcs.size());
+    Clock::time_point start = Clock::now();
+    region_index.reset();
+    // Rounds from dense_from on reach most of the map; they scan all pairs
+    // with DenseKernel instead of taking them from the queue.
+    const size_t dense_from = DenseKernel::first_dense_round(npcs.get_xs(), npcs.get_ys(), schedule, dense_threshold);
+    const std::vector<size_t>& radii = schedule.get_radii();
+    PairQueue queue(npcs.get_xs(), npcs.get_ys(),
+                    RadiusSchedule(std::vector<size_t>(radii.begin(), radii.begin() + dense_from)), spatial_index);
+    stats.set_index(elapsed_ms(start), queue.distance_tests());
+
+    // Survivor counts of the types present at the start, kept up to date from
+    // the kill matrix so that summaries cost O(types) per round.
+    std::vector<std::pair<NPCType, size_t>> alive_by_type;
+    if (config.survivor_report == SurvivorReport::Summary || config.survivor_report == SurvivorReport::Sampled)
+    {
+        std::vector<size_t> counts(TypeRegistry::count(), 0);
+        for (size_t i = 0; i < npcs.size(); ++i)
+        {
+            counts[static_cast<size_t>(npcs.type(i))] += npcs.is_alive(i) ? 1 : 0;
+        }
+        for (size_t type = 0; type < counts.size(); ++type)
+        {
+            if (counts[type] != 0)
+            {
+                alive_by_type.emplace_back(static_cast<NPCType>(type), counts[type]);
+            }
+        }
+    }
+
+    for (size_t round = 0; round < schedule.rounds(); ++round)
+    {
+        RoundStats& round_stats = stats.add_round(schedule.radius(round));
+
+        start = Clock::now();
+        report_survivors(round_stats, alive_by_type);
+        begin_observers(round_stats);
+        round_stats.report_ms = elapsed_ms(start);
+
+        start = Clock::now();
+        if (round >= dense_from)
+        {
+            resolve_dense(round == 0 ? std::nullopt : std::optional<size_t>(schedule.radius(round - 1)),
+                          schedule.radius(round), round_stats);
+        }
+        else if (resolution == ResolutionMode::Sequential)
+        {
+            resolve_sequential(queue.band(round), round_stats);
+        }
+        else
+        {
+            resolve_simultaneous(queue.band(round), round_stats);
+        }
+        round_stats.resolve_ms = elapsed_ms(start);
+
+        start = Clock::now();
+        end_observers(round_stats);
+        round_stats.notify_ms = elapsed_ms(start);
+        round_stats.alive = npcs.alive_count();
+        for (auto& [victim, alive] : alive_by_type)
+        {
+            for (size_t killer = 0; killer < round_stats.type_count; ++killer)
+            {
+                alive -= round_stats.kill_count(static_cast<NPCType>(killer), victim);
+            }
+        }
+
+        if (round + 1 < schedule.rounds() && npcs.dead_count() != 0 &&
+            static_cast<double>(npcs.dead_count()) >= compaction_threshold * static_cast<double>(npcs.size()))
+        {
+            start = Clock::now();
+            round_stats.compacted = npcs.dead_count();
+            const std::vector<std::uint32_t> remap = npcs.compact();
+            if (round + 1 < queue.rounds())
+            {
+                queue.compact(remap, round + 1);
+            }
+            region_index.reset();
+            round_stats.compact_ms = elapsed_ms(start);
+        }
+    }
+
+    if (config.survivor_report == SurvivorReport::FinalOnly)
     {
         print_survivors();
+    }
+    if (!config.result_path.empty())
+    {
+        save_to_file(config.result_path);
+    }
+    if (!config.stats_path.empty())
+    {
+        std::ofstream file(config.stats_path);
+        if (!file.is_open())
+        {
+            throw std::invalid_argument("Unable to save data to file");
+        }
+        stats.write(file, config.stats_format);
+    }
+}
+
+const BattleStats& Arena::get_battle_stats() const
+{
+    return stats;
+}
+
+void Arena::set_compaction_threshold(double ratio)
+{
+    if (!(ratio > 0))
+    {
+        throw std::invalid_argument("Compaction threshold must be positive");
+    }
+    compaction_threshold = ratio;
+}
+
+void Arena::set_dense_threshold(double fraction)
+{
+    if (!(fraction >= 0))
+    {
+        throw std::invalid_argument("Dense threshold must not be negative");
+    }
+    dense_threshold = fraction;
+}
+
+void Arena::set_resolution_mode(ResolutionMode mode)
+{
+    resolution = mode;
+}
+
+void Arena::set_thread_count(size_t threads)
+{
+    if (threads != pool->size())
+    {
+        pool = std::make_unique<ThreadPool>(threads);
+    }
+}
+
+void Arena::load_rules(const std::string& filename)
+{
+    rules = RuleTable::load(filename);
+}
+
+void Arena::set_rules(const RuleTable& table)
+{
+    rules = table;
+}
+
+const RuleTable& Arena::get_rules() const
+{
+    return rules;
+}
+
+void Arena::clear_npcs()
+{
+    region_index.reset();
+    npcs.clear();
+    npc_pool.release();
+}
+
+void Arena::set_async_observers(bool enabled, size_t capacity, BackPressure policy)
+{
+    pipeline.reset();
+    if (enabled)
+    {
+        pipeline = std::make_unique<EventPipeline>(observers, capacity, policy);
+    }
+}
+
+void Arena::resolve_sequential(std::span<const NPCPair> pairs, RoundStats& round)
+{
+    round.in_range_pairs += pairs.size();
+    for (const NPCPair& pair : pairs)
+    {
+        if (npcs.is_alive(pair.attacker) && npcs.is_alive(pair.defender))
+        {
+            ++round.pairs_considered;
+            const NPCType attacker = npcs.type(pair.attacker);
+            const NPCType defender = npcs.type(pair.defender);
+            if (rules.can_kill(attacker, defender))
+            {
+                npcs.kill(pair.defender);
+                round.add_kill(attacker, defender);
+                notify(pair, round);
+            }
+        }
+    }
+}
+
+void Arena::resolve_simultaneous(std::span<const NPCPair> pairs, RoundStats& round)
+{
+    round.in_range_pairs += pairs.size();
+    // Chunks are cut by pair position, not by thread, and merged in chunk
+    // order, so the kill list is the same for any number of threads.
+    const size_t chunks = (pairs.size() + SIMULTANEOUS_CHUNK - 1) / SIMULTANEOUS_CHUNK;
+    std::vector<std::vector<NPCPair>> kills(chunks);
+    std::vector<std::uint64_t> considered(chunks, 0);
+    pool->run(chunks, [this, pairs, &kills, &considered](size_t chunk)
+    {
+        const size_t begin = chunk * SIMULTANEOUS_CHUNK;
+        const size_t end = std::min(pairs.size(), begin + SIMULTANEOUS_CHUNK);
+        for (size_t k = begin; k < end; ++k)
+        {
+            const NPCPair& pair = pairs[k];
+            if (npcs.is_alive(pair.attacker) && npcs.is_alive(pair.defender))
+            {
+                ++considered[chunk];
+                if (rules.can_kill(npcs.type(pair.attacker), npcs.type(pair.defender)))
+                {
+                    kills[chunk].push_back(pair);
+                }
+            }
+        }
+    });
+    for (std::uint64_t count : considered)
+    {
+        round.pairs_considered += count;
+    }
+    apply_kills(kills, round);
+}
+
+void Arena::resolve_dense(std::optional<size_t> inner, size_t outer, RoundStats& round)
+{
+    const std::vector<int>& xs = npcs.get_xs();
+    const std::vector<int>& ys = npcs.get_ys();
+    const std::vector<std::uint64_t>& alive = npcs.get_alive_bits();
+    const size_t words = (npcs.size() + 63) / 64;
+    const size_t blocks = (npcs.size() + DenseKernel::BLOCK - 1) / DenseKernel::BLOCK;
+
+    // prey holds, per attacker type, the bitset of NPCs it can kill, so kills
+    // are found by masking rows instead of looking up each pair.
+    const size_t type_count = TypeRegistry::count();
+    std::vector<std::uint64_t> killers_of(type_count, 0);
+    for (size_t defender = 0; defender < type_count; ++defender)
+    {
+        for (size_t attacker = 0; attacker < type_count; ++attacker)
+        {
+            if (rules.can_kill(static_cast<NPCType>(attacker), static_cast<NPCType>(defender)))
+            {
+                killers_of[defender] |= std::uint64_t(1) << attacker;
+            }
+        }
+    }
+    std::vector<std::uint64_t> prey(type_count * words, 0);
+    for (size_t j = 0; j < npcs.size(); ++j)
+    {
+        for (std::uint64_t killers = killers_of[static_cast<size_t>(npcs.type(j))]; killers != 0; killers &= killers - 1)
+        {
+            prey[std::countr_zero(killers) * words + j / 64] |= std::uint64_t(1) << (j % 64);
+        }
+    }
 
-        for (auto& attacker : npcs)
+    // Rows only hold pairs whose sides were alive when they were computed,
+    // which is all that can matter; pairs are still handled in attacker, then
+    // defender order, as they would be from the queue. An attacker's own row
+    // cannot kill it, and each defender appears in it once, so the pairs it
+    // considers are exactly the living defenders of the row.
+    if (resolution == ResolutionMode::Sequential)
+    {
+        std::vector<std::uint64_t> rows;
+        for (size_t first = 0; first < npcs.size(); first += DenseKernel::BLOCK)
         {
-            for (auto& defender : npcs)
+            const size_t count = std::min(DenseKernel::BLOCK, npcs.size() - first);
+            round.distance_tests += DenseKernel::band_rows(xs, ys, first, count, inner, outer, alive, rows);
+            for (size_t a = 0; a < count; ++a)
             {
-                if (attacker != defender && attacker->is_alive && defender->is_alive)
+                const size_t attacker = first + a;
+                if (!npcs.is_alive(attacker))
+                {
+                    continue;
+                }
+                const std::uint64_t* victims = prey.data() + static_cast<size_t>(npcs.type(attacker)) * words;
+                for (size_t word = 0; word < words; ++word)
                 {
-                    if (attacker->is_close(*defender, start_range))
+                    const std::uint64_t live = rows[a * words + word] & alive[word];
+                    round.in_range_pairs += std::popcount(live);
+                    round.pairs_considered += std::popcount(live);
+                    for (std::uint64_t bits = live & victims[word]; bits != 0; bits &= bits - 1)
                     {
-                        BattleVisitor visitor(attacker, observers);
-                        defender->accept(visitor);
+                        const NPCPair pair{static_cast<std::uint32_t>(attacker),
+                                           static_cast<std::uint32_t>(word * 64 + std::countr_zero(bits))};
+                        npcs.kill(pair.defender);
+                        round.add_kill(npcs.type(pair.attacker), npcs.type(pair.defender));
+                        notify(pair, round);
                     }
                 }
             }
         }
+        return;
+    }
+
+    std::vector<std::vector<NPCPair>> kills(blocks);
+    std::vector<std::uint64_t> in_range(blocks, 0);
+    std::vector<std::uint64_t> tests(blocks, 0);
+    pool->run(blocks, [&](size_t block)
+    {
+        const size_t first = block * DenseKernel::BLOCK;
+        const size_t count = std::min(DenseKernel::BLOCK, npcs.size() - first);
+        std::vector<std::uint64_t> rows;
+        tests[block] = DenseKernel::band_rows(xs, ys, first, count, inner, outer, alive, rows);
+        for (size_t a = 0; a < count; ++a)
+        {
+            const std::uint64_t* victims = prey.data() + static_cast<size_t>(npcs.type(first + a)) * words;
+            for (size_t word = 0; word < words; ++word)
+            {
+                in_range[block] += std::popcount(rows[a * words + word]);
+                for (std::uint64_t bits = rows[a * words + word] & victims[word]; bits != 0; bits &= bits - 1)
+                {
+                    kills[block].push_back({static_cast<std::uint32_t>(first + a),
+                                            static_cast<std::uint32_t>(word * 64 + std::countr_zero(bits))});
+                }
+            }
+        }
+    });
+    for (size_t block = 0; block < blocks; ++block)
+    {
+        round.in_range_pairs += in_range[block];
+        round.pairs_considered += in_range[block];
+        round.distance_tests += tests[block];
+    }
+    apply_kills(kills, round);
+}
+
+void Arena::apply_kills(const std::vector<std::vector<NPCPair>>& kills, RoundStats& round)
+{
+    // A victim reached by several attackers is credited to the first of them.
+    for (const auto& chunk : kills)
+    {
+        for (const NPCPair& pair : chunk)
+        {
+            if (npcs.is_alive(pair.defender))
+            {
+                const NPCType attacker = npcs.type(pair.attacker);
+                const NPCType defender = npcs.type(pair.defender);
+                npcs.kill(pair.defender);
+                round.add_kill(attacker, defender);
+                notify(pair, round);
+            }
+        }
+    }
+}
 
-        start_range += 10;
+void Arena::begin_observers(const RoundStats& round)
+{
+    const auto index = static_cast<std::uint32_t>(round.round);
+    if (pipeline)
+    {
+        pipeline->begin_round(index, round.radius);
+        return;
+    }
+    round_events.reserve(ROUND_EVENTS);
+    for (const auto& observer : observers)
+    {
+        observer->on_round_begin(index, round.radius);
+    }
+}
+
+void Arena::notify(const NPCPair& pair, const RoundStats& round)
+{
+    KillEvent event{npcs.type(pair.attacker), npcs.type(pair.defender)};
+    event.round = static_cast<std::uint32_t>(round.round);
+    event.radius = round.radius;
+    event.killer_id = npcs.handle(pair.attacker).id;
+    event.victim_id = npcs.handle(pair.defender).id;
+    event.killer_x = npcs.x(pair.attacker);
+    event.killer_y = npcs.y(pair.attacker);
+    event.victim_x = npcs.x(pair.defender);
+    event.victim_y = npcs.y(pair.defender);
+    if (pipeline)
+    {
+        pipeline->push(event);
+        return;
+    }
+    if (observers.empty())
+    {
+        return;
+    }
+    round_events.push_back(event);
+    if (round_events.size() == ROUND_EVENTS)
+    {
+        deliver_events();
     }
+}
 
-    save_to_file("../res.txt");
+void Arena::deliver_events()
+{
+    if (round_events.empty())
+    {
+        return;
+    }
+    for (const auto& observer : observers)
+    {
+        observer->on_round(round_events);
+    }
+    round_events.clear();
 }
 
-void Arena::clear_npcs()
+void Arena::end_observers(const RoundStats& round)
 {
-    npcs.clear();
+    const auto index = static_cast<std::uint32_t>(round.round);
+    if (pipeline)
+    {
+        pipeline->end_round(index);
+        return;
+    }
+    deliver_events();
+    for (const auto& observer : observers)
+    {
+        observer->on_round_end(index);
+    }
 }
\ No newline at end of file
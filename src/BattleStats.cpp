@@ -0,0 +1,235 @@
+#include "BattleStats.h"
+
+#include <algorithm>
+#include <numeric>
+#include "TypeRegistry.h"
+
+namespace
+{
+    void write_metric(std::ostream& out, const char* name, const char* type, const char* help)
+    {
+        out << "# HELP lab6_" << name << ' ' << help << '\n'
+            << "# TYPE lab6_" << name << ' ' << type << '\n';
+    }
+
+    void write_gauge(std::ostream& out, const char* name, const char* help)
+    {
+        write_metric(out, name, "gauge", help);
+    }
+}
+
+void RoundStats::add_kill(NPCType killer, NPCType victim)
+{
+    ++kills[static_cast<size_t>(killer) * type_count + static_cast<size_t>(victim)];
+}
+
+std::uint64_t RoundStats::kill_count() const
+{
+    return std::accumulate(kills.begin(), kills.end(), std::uint64_t(0));
+}
+
+std::uint64_t RoundStats::kill_count(NPCType killer, NPCType victim) const
+{
+    const auto a = static_cast<size_t>(killer);
+    const auto v = static_cast<size_t>(victim);
+    return a < type_count && v < type_count ? kills[a * type_count + v] : 0;
+}
+
+void BattleStats::reset(size_t npcs)
+{
+    this->npcs = npcs;
+    index_distance_tests = 0;
+    index_ms = 0;
+    rounds.clear();
+}
+
+void BattleStats::set_index(double ms, std::uint64_t distance_tests)
+{
+    index_ms = ms;
+    index_distance_tests = distance_tests;
+}
+
+RoundStats& BattleStats::add_round(size_t radius)
+{
+    RoundStats& round = rounds.emplace_back();
+    round.round = rounds.size() - 1;
+    round.radius = radius;
+    round.type_count = TypeRegistry::count();
+    round.kills.assign(round.type_count * round.type_count, 0);
+    return round;
+}
+
+size_t BattleStats::get_npcs() const
+{
+    return npcs;
+}
+
+std::uint64_t BattleStats::get_index_distance_tests() const
+{
+    return index_distance_tests;
+}
+
+double BattleStats::get_index_ms() const
+{
+    return index_ms;
+}
+
+const std::vector<RoundStats>& BattleStats::get_rounds() const
+{
+    return rounds;
+}
+
+RoundStats BattleStats::totals() const
+{
+    RoundStats total;
+    total.alive = npcs;
+    for (const RoundStats& round : rounds)
+    {
+        total.type_count = std::max(total.type_count, round.type_count);
+    }
+    total.kills.assign(total.type_count * total.type_count, 0);
+    for (const RoundStats& round : rounds)
+    {
+        total.round = round.round;
+        total.radius = round.radius;
+        total.in_range_pairs += round.in_range_pairs;
+        total.pairs_considered += round.pairs_considered;
+        total.distance_tests += round.distance_tests;
+        for (size_t a = 0; a < round.type_count; ++a)
+        {
+            for (size_t v = 0; v < round.type_count; ++v)
+            {
+                total.kills[a * total.type_count + v] += round.kills[a * round.type_count + v];
+            }
+        }
+        total.alive = round.alive;
+        total.compacted += round.compacted;
+        total.report_ms += round.report_ms;
+        total.resolve_ms += round.resolve_ms;
+        total.notify_ms += round.notify_ms;
+        total.compact_ms += round.compact_ms;
+    }
+    return total;
+}
+
+void BattleStats::write(std::ostream& out, StatsFormat format) const
+{
+    if (format == StatsFormat::Prometheus)
+    {
+        write_prometheus(out);
+    }
+    else
+    {
+        write_json_lines(out);
+    }
+}
+
+void BattleStats::write_prometheus(std::ostream& out) const
+{
+    write_gauge(out, "index_distance_tests", "Distance tests spent building the pair queue.");
+    out << "lab6_index_distance_tests " << index_distance_tests << '\n';
+    write_gauge(out, "index_seconds", "Wall time spent building the pair queue.");
+    out << "lab6_index_seconds " << index_ms / 1000 << '\n';
+
+    write_gauge(out, "round_in_range_pairs", "Pairs that came into range in the round.");
+    for (const RoundStats& round : rounds)
+    {
+        out << "lab6_round_in_range_pairs{round=\"" << round.round << "\"} " << round.in_range_pairs << '\n';
+    }
+    write_gauge(out, "round_pairs_considered", "Pairs checked against the kill table in the round.");
+    for (const RoundStats& round : rounds)
+    {
+        out << "lab6_round_pairs_considered{round=\"" << round.round << "\"} " << round.pairs_considered << '\n';
+    }
+    write_gauge(out, "round_distance_tests", "Distance tests done in the round.");
+    for (const RoundStats& round : rounds)
+    {
+        out << "lab6_round_distance_tests{round=\"" << round.round << "\"} " << round.distance_tests << '\n';
+    }
+    write_gauge(out, "round_alive", "NPCs alive after the round.");
+    for (const RoundStats& round : rounds)
+    {
+        out << "lab6_round_alive{round=\"" << round.round << "\"} " << round.alive << '\n';
+    }
+    write_gauge(out, "round_compacted", "Dead NPCs compacted out of the store after the round.");
+    for (const RoundStats& round : rounds)
+    {
+        out << "lab6_round_compacted{round=\"" << round.round << "\"} " << round.compacted << '\n';
+    }
+    write_gauge(out, "round_kills", "Kills in the round by killer and victim type.");
+    for (const RoundStats& round : rounds)
+    {
+        for (size_t a = 0; a < round.type_count; ++a)
+        {
+            for (size_t v = 0; v < round.type_count; ++v)
+            {
+                const std::uint64_t count = round.kills[a * round.type_count + v];
+                if (count != 0)
+                {
+                    out << "lab6_round_kills{round=\"" << round.round
+                        << "\",killer=\"" << TypeRegistry::name(static_cast<NPCType>(a))
+                        << "\",victim=\"" << TypeRegistry::name(static_cast<NPCType>(v))
+                        << "\"} " << count << '\n';
+                }
+            }
+        }
+    }
+    // Running totals over the battle only grow, so they are counters.
+    write_metric(out, "kills_total", "counter", "Kills so far in the battle by killer and victim type.");
+    const RoundStats total = totals();
+    for (size_t a = 0; a < total.type_count; ++a)
+    {
+        for (size_t v = 0; v < total.type_count; ++v)
+        {
+            const std::uint64_t count = total.kills[a * total.type_count + v];
+            if (count != 0)
+            {
+                out << "lab6_kills_total{killer=\"" << TypeRegistry::name(static_cast<NPCType>(a))
+                    << "\",victim=\"" << TypeRegistry::name(static_cast<NPCType>(v))
+                    << "\"} " << count << '\n';
+            }
+        }
+    }
+    write_gauge(out, "round_phase_seconds", "Wall time of each phase of the round.");
+    for (const RoundStats& round : rounds)
+    {
+        out << "lab6_round_phase_seconds{round=\"" << round.round << "\",phase=\"report\"} "
+            << round.report_ms / 1000 << '\n'
+            << "lab6_round_phase_seconds{round=\"" << round.round << "\",phase=\"resolve\"} "
+            << round.resolve_ms / 1000 << '\n'
+            << "lab6_round_phase_seconds{round=\"" << round.round << "\",phase=\"notify\"} "
+            << round.notify_ms / 1000 << '\n'
+            << "lab6_round_phase_seconds{round=\"" << round.round << "\",phase=\"compact\"} "
+            << round.compact_ms / 1000 << '\n';
+    }
+}
+
+void BattleStats::write_json_lines(std::ostream& out) const
+{
+    out << "{\"index\": {\"npcs\": " << npcs << ", \"distance_tests\": " << index_distance_tests
+        << ", \"ms\": " << index_ms << "}}\n";
+    for (const RoundStats& round : rounds)
+    {
+        out << "{\"round\": " << round.round << ", \"radius\": " << round.radius
+            << ", \"in_range_pairs\": " << round.in_range_pairs
+            << ", \"pairs_considered\": " << round.pairs_considered
+            << ", \"distance_tests\": " << round.distance_tests
+            << ", \"alive\": " << round.alive << ", \"compacted\": " << round.compacted << ", \"kills\": {";
+        bool first = true;
+        for (size_t a = 0; a < round.type_count; ++a)
+        {
+            for (size_t v = 0; v < round.type_count; ++v)
+            {
+                const std::uint64_t count = round.kills[a * round.type_count + v];
+                if (count != 0)
+                {
+                    out << (first ? "" : ", ") << '"' << TypeRegistry::name(static_cast<NPCType>(a)) << '>'
+                        << TypeRegistry::name(static_cast<NPCType>(v)) << "\": " << count;
+                    first = false;
+                }
+            }
+        }
+        out << "}, \"report_ms\": " << round.report_ms << ", \"resolve_ms\": " << round.resolve_ms
+            << ", \"notify_ms\": " << round.notify_ms << ", \"compact_ms\": " << round.compact_ms << "}\n";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "BufferedWriter.h"
+
+#include <cstring>
+
+BufferedWriter::BufferedWriter(std::ostream& out) : out(out), buffer(std::make_unique<char[]>(CAPACITY)) {}
+
+BufferedWriter::~BufferedWriter()
+{
+    flush();
+}
+
+BufferedWriter& BufferedWriter::operator<<(std::string_view text)
+{
+    if (text.size() > CAPACITY - used)
+    {
+        flush();
+        if (text.size() > CAPACITY)
+        {
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+            return *this;
+        }
+    }
+    std::memcpy(buffer.get() + used, text.data(), text.size());
+    used += text.size();
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(char c)
+{
+    if (used == CAPACITY)
+    {
+        flush();
+    }
+    buffer[used++] = c;
+    return *this;
+}
+
+void BufferedWriter::flush()
+{
+    if (used != 0)
+    {
+        out.write(buffer.get(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+    out.flush();
+}
\ No newline at end of file
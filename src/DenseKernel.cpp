@@ -0,0 +1,82 @@
+#include "DenseKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include "DistanceKernel.h"
+
+size_t DenseKernel::first_dense_round(const std::vector<int>& xs, const std::vector<int>& ys,
+                                      const RadiusSchedule& schedule, double threshold)
+{
+    if (xs.size() < 2)
+    {
+        return schedule.rounds();
+    }
+    const auto [min_x, max_x] = std::minmax_element(xs.begin(), xs.end());
+    const auto [min_y, max_y] = std::minmax_element(ys.begin(), ys.end());
+    const double width = double(*max_x) - *min_x + 1;
+    const double height = double(*max_y) - *min_y + 1;
+    const double area = width * height;
+
+    for (size_t round = 0; round < schedule.rounds(); ++round)
+    {
+        // On a long or thin map most of the circle lies outside the bounding
+        // box, so it is also bounded by its square window clipped per axis.
+        const auto radius = static_cast<double>(schedule.radius(round));
+        const double side = 2 * radius + 1;
+        const double covered = std::min(std::numbers::pi * radius * radius,
+                                        std::min(side, width) * std::min(side, height));
+        if (std::min(1.0, covered / area) > threshold)
+        {
+            return round;
+        }
+    }
+    return schedule.rounds();
+}
+
+std::uint64_t DenseKernel::band_rows(const std::vector<int>& xs, const std::vector<int>& ys, size_t first, size_t count,
+                                     std::optional<size_t> inner, size_t outer,
+                                     std::span<const std::uint64_t> candidates, std::vector<std::uint64_t>& rows)
+{
+    const size_t n = xs.size();
+    const size_t words = (n + 63) / 64;
+    if (ys.size() != n || first + count > n || candidates.size() < words)
+    {
+        throw std::invalid_argument("Dense kernel arguments do not match");
+    }
+
+    rows.assign(count * words, 0);
+    std::uint64_t tests = 0;
+    for (size_t tile = 0; tile < n; tile += TILE)
+    {
+        const size_t tile_end = std::min(n, tile + TILE);
+        for (size_t a = 0; a < count; ++a)
+        {
+            const size_t i = first + a;
+            if (((candidates[i / 64] >> (i % 64)) & 1) == 0)
+            {
+                continue;
+            }
+            std::uint64_t* row = rows.data() + a * words;
+            for (size_t j = tile; j < tile_end; j += DistanceKernel::BLOCK)
+            {
+                const std::uint64_t live = candidates[j / 64];
+                if (live == 0)
+                {
+                    continue;
+                }
+                const size_t block = std::min(DistanceKernel::BLOCK, n - j);
+                tests += block;
+                std::uint64_t mask = DistanceKernel::in_range_mask(xs[i], ys[i], xs.data() + j, ys.data() + j, block, outer) & live;
+                if (mask != 0 && inner)
+                {
+                    mask &= ~DistanceKernel::in_range_mask(xs[i], ys[i], xs.data() + j, ys.data() + j, block, *inner);
+                }
+                row[j / 64] = mask;
+            }
+            row[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+        }
+    }
+    return tests;
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "DistanceKernel.h"
+
+#include <atomic>
+#include <climits>
+#include <stdexcept>
+#include "NPC.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LAB6_X86 1
+#endif
+
+namespace
+{
+    using MaskFunction = std::uint64_t (*)(int, int, const int*, const int*, size_t, unsigned long long);
+
+    std::uint64_t scalar_mask(int x, int y, const int* xs, const int* ys, size_t count, unsigned long long limit)
+    {
+        std::uint64_t mask = 0;
+        for (size_t k = 0; k < count; ++k)
+        {
+            if (NPC::squared_distance(x, y, xs[k], ys[k]) <= limit)
+            {
+                mask |= std::uint64_t(1) << k;
+            }
+        }
+        return mask;
+    }
+
+#ifdef LAB6_X86
+    // Both kernels test dx^2 <= r^2 and dy^2 <= r^2 - dx^2, which is exact in
+    // 64 bits as long as r^2 itself fits (the caller guarantees r < 2^32).
+    __attribute__((target("sse4.2")))
+    std::uint64_t sse_mask(int x, int y, const int* xs, const int* ys, size_t count, unsigned long long limit)
+    {
+        const __m128i ax = _mm_set1_epi64x(x);
+        const __m128i ay = _mm_set1_epi64x(y);
+        const __m128i bias = _mm_set1_epi64x(LLONG_MIN);
+        const __m128i r2 = _mm_set1_epi64x(static_cast<long long>(limit));
+        const __m128i r2_biased = _mm_xor_si128(r2, bias);
+        const __m128i zero = _mm_setzero_si128();
+
+        std::uint64_t mask = 0;
+        size_t k = 0;
+        for (; k + 2 <= count; k += 2)
+        {
+            const __m128i dx = _mm_sub_epi64(_mm_cvtepi32_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(xs + k))), ax);
+            const __m128i dy = _mm_sub_epi64(_mm_cvtepi32_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ys + k))), ay);
+            const __m128i sx = _mm_cmpgt_epi64(zero, dx);
+            const __m128i sy = _mm_cmpgt_epi64(zero, dy);
+            const __m128i abs_x = _mm_sub_epi64(_mm_xor_si128(dx, sx), sx);
+            const __m128i abs_y = _mm_sub_epi64(_mm_xor_si128(dy, sy), sy);
+            const __m128i dx2 = _mm_mul_epu32(abs_x, abs_x);
+            const __m128i dy2 = _mm_mul_epu32(abs_y, abs_y);
+
+            const __m128i x_out = _mm_cmpgt_epi64(_mm_xor_si128(dx2, bias), r2_biased);
+            const __m128i rest = _mm_xor_si128(_mm_sub_epi64(r2, dx2), bias);
+            const __m128i y_out = _mm_cmpgt_epi64(_mm_xor_si128(dy2, bias), rest);
+            const int out = _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(x_out, y_out)));
+            mask |= std::uint64_t(~out & 0x3) << k;
+        }
+        if (k < count)
+        {
+            mask |= scalar_mask(x, y, xs + k, ys + k, count - k, limit) << k;
+        }
+        return mask;
+    }
+
+    __attribute__((target("avx2")))
+    std::uint64_t avx2_mask(int x, int y, const int* xs, const int* ys, size_t count, unsigned long long limit)
+    {
+        const __m256i ax = _mm256_set1_epi64x(x);
+        const __m256i ay = _mm256_set1_epi64x(y);
+        const __m256i bias = _mm256_set1_epi64x(LLONG_MIN);
+        const __m256i r2 = _mm256_set1_epi64x(static_cast<long long>(limit));
+        const __m256i r2_biased = _mm256_xor_si256(r2, bias);
+        const __m256i zero = _mm256_setzero_si256();
+
+        std::uint64_t mask = 0;
+        size_t k = 0;
+        for (; k + 4 <= count; k += 4)
+        {
+            const __m256i dx = _mm256_sub_epi64(_mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + k))), ax);
+            const __m256i dy = _mm256_sub_epi64(_mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + k))), ay);
+            const __m256i sx = _mm256_cmpgt_epi64(zero, dx);
+            const __m256i sy = _mm256_cmpgt_epi64(zero, dy);
+            const __m256i abs_x = _mm256_sub_epi64(_mm256_xor_si256(dx, sx), sx);
+            const __m256i abs_y = _mm256_sub_epi64(_mm256_xor_si256(dy, sy), sy);
+            const __m256i dx2 = _mm256_mul_epu32(abs_x, abs_x);
+            const __m256i dy2 = _mm256_mul_epu32(abs_y, abs_y);
+
+            const __m256i x_out = _mm256_cmpgt_epi64(_mm256_xor_si256(dx2, bias), r2_biased);
+            const __m256i rest = _mm256_xor_si256(_mm256_sub_epi64(r2, dx2), bias);
+            const __m256i y_out = _mm256_cmpgt_epi64(_mm256_xor_si256(dy2, bias), rest);
+            const int out = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_or_si256(x_out, y_out)));
+            mask |= std::uint64_t(~out & 0xF) << k;
+        }
+        if (k < count)
+        {
+            mask |= scalar_mask(x, y, xs + k, ys + k, count - k, limit) << k;
+        }
+        return mask;
+    }
+#endif
+
+    DistanceKernel::Isa detect_isa()
+    {
+#ifdef LAB6_X86
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return DistanceKernel::Isa::AVX2;
+        }
+        if (__builtin_cpu_supports("sse4.2"))
+        {
+            return DistanceKernel::Isa::SSE;
+        }
+#endif
+        return DistanceKernel::Isa::Scalar;
+    }
+
+    MaskFunction function_for(DistanceKernel::Isa isa)
+    {
+#ifdef LAB6_X86
+        switch (isa)
+        {
+            case DistanceKernel::Isa::AVX2:
+                return avx2_mask;
+            case DistanceKernel::Isa::SSE:
+                return sse_mask;
+            case DistanceKernel::Isa::Scalar:
+                break;
+        }
+#endif
+        return scalar_mask;
+    }
+
+    const DistanceKernel::Isa best_isa = detect_isa();
+    std::atomic<DistanceKernel::Isa> current_isa = best_isa;
+    std::atomic<MaskFunction> current_function = function_for(best_isa);
+}
+
+std::uint64_t DistanceKernel::in_range_mask(int x, int y, const int* xs, const int* ys, size_t count, size_t radius)
+{
+    if (count > BLOCK)
+    {
+        throw std::invalid_argument("Kernel block is limited to 64 defenders");
+    }
+
+    const unsigned long long limit = NPC::squared_radius(radius);
+    if (radius > UINT_MAX)
+    {
+        return scalar_mask(x, y, xs, ys, count, limit);
+    }
+    return current_function.load(std::memory_order_relaxed)(x, y, xs, ys, count, limit);
+}
+
+DistanceKernel::Isa DistanceKernel::get_isa()
+{
+    return current_isa.load(std::memory_order_relaxed);
+}
+
+bool DistanceKernel::is_supported(Isa isa)
+{
+    return static_cast<int>(isa) <= static_cast<int>(best_isa);
+}
+
+void DistanceKernel::set_isa(Isa isa)
+{
+    if (!is_supported(isa))
+    {
+        throw std::invalid_argument("Instruction set is not supported by this CPU");
+    }
+    current_isa.store(isa, std::memory_order_relaxed);
+    current_function.store(function_for(isa), std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "EventPipeline.h"
+
+#include <utility>
+
+EventPipeline::EventPipeline(std::vector<std::shared_ptr<IObserver>> observers, size_t capacity, BackPressure policy) :
+                            observers(std::move(observers)), queue(capacity), policy(policy)
+{
+    dispatcher = std::thread(&EventPipeline::dispatch_loop, this);
+}
+
+EventPipeline::~EventPipeline()
+{
+    flush();
+    stopping.store(true);
+    wake();
+    dispatcher.join();
+}
+
+void EventPipeline::push(const KillEvent& event)
+{
+    while (!queue.try_push(event))
+    {
+        if (policy == BackPressure::CountDrops)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (policy == BackPressure::DropOldest)
+        {
+            KillEvent oldest{};
+            if (queue.try_pop(oldest))
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                retired.fetch_add(1);
+            }
+            continue;
+        }
+
+        // Block: retry once after sampling the counter so that a dispatcher
+        // which drained the queue in between cannot leave us waiting forever.
+        const size_t seen = retired.load();
+        if (queue.try_push(event))
+        {
+            break;
+        }
+        wake();
+        retired.wait(seen);
+    }
+
+    // The counter is bumped on every push: the dispatcher waits on the value
+    // it saw before its last pop, so an event that lands after that pop ends
+    // the wait even if the dispatcher was not idle yet when we looked.
+    accepted.fetch_add(1);
+    signal.fetch_add(1);
+    if (idle.load())
+    {
+        signal.notify_one();
+    }
+}
+
+void EventPipeline::begin_round(std::uint32_t round, std::uint64_t radius)
+{
+    request(Control::Begin, round, radius);
+}
+
+void EventPipeline::end_round(std::uint32_t round)
+{
+    request(Control::End, round, 0);
+}
+
+void EventPipeline::flush()
+{
+    request(Control::Flush, 0, 0);
+}
+
+size_t EventPipeline::delivered_count() const
+{
+    return delivered.load();
+}
+
+size_t EventPipeline::dropped_count() const
+{
+    return dropped.load();
+}
+
+size_t EventPipeline::get_capacity() const
+{
+    return queue.capacity();
+}
+
+BackPressure EventPipeline::get_policy() const
+{
+    return policy;
+}
+
+void EventPipeline::request(Control kind, std::uint32_t round, std::uint64_t radius)
+{
+    const size_t target = accepted.load();
+    for (size_t seen = retired.load(); seen < target; seen = retired.load())
+    {
+        wake();
+        retired.wait(seen);
+    }
+
+    // The previous request has completed, so the dispatcher is not reading these.
+    control = kind;
+    control_round = round;
+    control_radius = radius;
+    const size_t ticket = control_requested.fetch_add(1) + 1;
+    wake();
+    for (size_t seen = control_completed.load(); seen < ticket; seen = control_completed.load())
+    {
+        control_completed.wait(seen);
+    }
+}
+
+void EventPipeline::wake()
+{
+    signal.fetch_add(1);
+    signal.notify_one();
+}
+
+void EventPipeline::dispatch_loop()
+{
+    std::vector<KillEvent> batch;
+    batch.reserve(BATCH);
+
+    while (true)
+    {
+        const size_t seen = signal.load();
+
+        KillEvent event{};
+        while (batch.size() < BATCH && queue.try_pop(event))
+        {
+            batch.push_back(event);
+        }
+
+        if (!batch.empty())
+        {
+            for (const auto& observer : observers)
+            {
+                observer->on_round(batch);
+            }
+            delivered.fetch_add(batch.size());
+            retired.fetch_add(batch.size());
+            retired.notify_all();
+            batch.clear();
+            continue;
+        }
+
+        const size_t ticket = control_requested.load();
+        if (ticket != control_completed.load() && retired.load() >= accepted.load())
+        {
+            for (const auto& observer : observers)
+            {
+                switch (control)
+                {
+                    case Control::Begin:
+                        observer->on_round_begin(control_round, control_radius);
+                        break;
+                    case Control::End:
+                        observer->on_round_end(control_round);
+                        break;
+                    case Control::Flush:
+                        observer->flush();
+                        break;
+                }
+            }
+            control_completed.store(ticket);
+            control_completed.notify_all();
+            continue;
+        }
+
+        if (stopping.load())
+        {
+            return;
+        }
+
+        idle.store(true);
+        signal.wait(seen);
+        idle.store(false);
+    }
+}
\ No newline at end of file
@@ -1,21 +1,41 @@
 #include "Factory.h"
 
 #include <stdexcept>
+#include "NPCTypeList.h"
+#include "TypeRegistry.h"
 
 std::shared_ptr<NPC> INPCFactory::create_npc(const std::string& type, int x, int y)
 {
-    if (type == "Dragon")
+    return create_npc(TypeRegistry::find(type), x, y);
+}
+
+std::shared_ptr<NPC> INPCFactory::create_npc(NPCType type, int x, int y)
+{
+    if (static_cast<size_t>(type) >= NPC_TYPE_COUNT)
     {
-        return std::make_shared<Dragon>(x, y);
+        TypeRegistry::name(type); // throws for ids that were never registered
+        return std::make_shared<CustomNPC>(type, x, y);
     }
-    if (type == "Frog")
+    return visit_npc_type(type, [x, y]<typename T>(std::type_identity<T>) -> std::shared_ptr<NPC>
     {
-        return std::make_shared<Frog>(x, y);
-    }
-    if (type == "Knight")
+        return std::make_shared<T>(x, y);
+    });
+}
+
+std::shared_ptr<NPC> INPCFactory::create_npc(NPCType type, int x, int y, NPCPool& pool)
+{
+    if (static_cast<size_t>(type) >= NPC_TYPE_COUNT)
     {
-        return std::make_shared<Knight>(x, y);
+        TypeRegistry::name(type); // throws for ids that were never registered
+        return pool.make<CustomNPC>(type, x, y);
     }
+    return visit_npc_type(type, [x, y, &pool]<typename T>(std::type_identity<T>) -> std::shared_ptr<NPC>
+    {
+        return pool.make<T>(x, y);
+    });
+}
 
-    throw std::invalid_argument("Unknown type");
+NPCHandle INPCFactory::create_npc(NPCStore& store, const std::string& type, int x, int y)
+{
+    return store.add(TypeRegistry::find(type), x, y);
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "KdTree.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include "DistanceKernel.h"
+#include "NPC.h"
+
+KdTree::KdTree(const std::vector<int>& x, const std::vector<int>& y)
+{
+    if (x.size() != y.size())
+    {
+        throw std::invalid_argument("Coordinate arrays differ in size");
+    }
+    if (x.size() >= std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::invalid_argument("Too many points for a k-d tree");
+    }
+    if (x.empty())
+    {
+        return;
+    }
+
+    ids.resize(x.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    nodes.reserve(2 * (x.size() / LEAF + 1));
+    build(x, y, 0, x.size());
+
+    xs.resize(ids.size());
+    ys.resize(ids.size());
+    for (std::size_t i = 0; i < ids.size(); ++i)
+    {
+        xs[i] = x[ids[i]];
+        ys[i] = y[ids[i]];
+    }
+}
+
+std::uint32_t KdTree::build(const std::vector<int>& x, const std::vector<int>& y, std::size_t begin, std::size_t end)
+{
+    const auto index = static_cast<std::uint32_t>(nodes.size());
+    nodes.push_back(Node{x[ids[begin]], x[ids[begin]], y[ids[begin]], y[ids[begin]],
+                         static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end), 0, 0});
+    Node node = nodes.back();
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        node.min_x = std::min(node.min_x, x[ids[i]]);
+        node.max_x = std::max(node.max_x, x[ids[i]]);
+        node.min_y = std::min(node.min_y, y[ids[i]]);
+        node.max_y = std::max(node.max_y, y[ids[i]]);
+    }
+
+    // Children always have a larger index than the root, so 0 marks a leaf.
+    const bool flat = node.min_x == node.max_x && node.min_y == node.max_y;
+    if (end - begin > LEAF && !flat)
+    {
+        const std::vector<int>& axis = (std::int64_t(node.max_x) - node.min_x >= std::int64_t(node.max_y) - node.min_y)
+                                       ? x : y;
+        const std::size_t middle = begin + (end - begin) / 2;
+        std::nth_element(ids.begin() + begin, ids.begin() + middle, ids.begin() + end,
+                         [&axis](std::size_t a, std::size_t b) { return axis[a] < axis[b]; });
+        node.left = build(x, y, begin, middle);
+        node.right = build(x, y, middle, end);
+    }
+    nodes[index] = node;
+    return index;
+}
+
+std::size_t KdTree::query(int x, int y, std::size_t radius, std::vector<std::size_t>& out) const
+{
+    std::size_t tests = 0;
+    if (nodes.empty())
+    {
+        return tests;
+    }
+
+    const unsigned long long limit = NPC::squared_radius(radius);
+    std::vector<std::uint32_t> stack = {0};
+    while (!stack.empty())
+    {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        const int near_x = std::clamp(x, node.min_x, node.max_x);
+        const int near_y = std::clamp(y, node.min_y, node.max_y);
+        if (NPC::squared_distance(x, y, near_x, near_y) > limit)
+        {
+            continue;
+        }
+
+        const int far_x = (std::int64_t(x) - node.min_x > std::int64_t(node.max_x) - x) ? node.min_x : node.max_x;
+        const int far_y = (std::int64_t(y) - node.min_y > std::int64_t(node.max_y) - y) ? node.min_y : node.max_y;
+        if (NPC::squared_distance(x, y, far_x, far_y) <= limit)
+        {
+            for (std::uint32_t i = node.begin; i < node.end; ++i)
+            {
+                out.push_back(ids[i]);
+            }
+            continue;
+        }
+
+        if (node.left != 0)
+        {
+            stack.push_back(node.right);
+            stack.push_back(node.left);
+            continue;
+        }
+
+        tests += node.end - node.begin;
+        for (std::size_t block = node.begin; block < node.end; block += DistanceKernel::BLOCK)
+        {
+            const std::size_t count = std::min<std::size_t>(DistanceKernel::BLOCK, node.end - block);
+            std::uint64_t mask = DistanceKernel::in_range_mask(x, y, xs.data() + block, ys.data() + block, count, radius);
+            while (mask != 0)
+            {
+                out.push_back(ids[block + std::countr_zero(mask)]);
+                mask &= mask - 1;
+            }
+        }
+    }
+    return tests;
+}
+
+std::size_t KdTree::size() const
+{
+    return ids.size();
+}
+
+std::size_t KdTree::depth() const
+{
+    std::size_t deepest = 0;
+    std::vector<std::pair<std::uint32_t, std::size_t>> stack;
+    if (!nodes.empty())
+    {
+        stack.emplace_back(0, 1);
+    }
+    while (!stack.empty())
+    {
+        const auto [index, level] = stack.back();
+        stack.pop_back();
+        deepest = std::max(deepest, level);
+        if (nodes[index].left != 0)
+        {
+            stack.emplace_back(nodes[index].left, level + 1);
+            stack.emplace_back(nodes[index].right, level + 1);
+        }
+    }
+    return deepest;
+}
\ No newline at end of file
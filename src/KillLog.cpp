@@ -0,0 +1,434 @@
+#include "KillLog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include "TypeRegistry.h"
+
+namespace
+{
+    constexpr char CHUNK_MAGIC[4] = {'K', 'C', 'H', 'K'};
+
+    enum Column
+    {
+        ROUND,
+        RADIUS,
+        KILLER,
+        VICTIM,
+        KILLER_ID,
+        VICTIM_ID,
+        KILLER_X,
+        KILLER_Y,
+        VICTIM_X,
+        VICTIM_Y,
+        COLUMNS
+    };
+
+    struct FileHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t type_count;
+    };
+
+    struct ChunkHeader
+    {
+        char magic[4];
+        std::uint32_t count;
+        std::uint32_t first_round;
+        std::uint32_t last_round;
+        std::int32_t min_x;
+        std::int32_t max_x;
+        std::int32_t min_y;
+        std::int32_t max_y;
+        std::uint64_t killers;
+        std::uint64_t victims;
+        std::uint32_t column_bytes[COLUMNS];
+        // Type names appended to the dictionary, stored between the header
+        // and the columns.
+        std::uint32_t added_types;
+        std::uint32_t added_bytes;
+    };
+
+    void corrupted()
+    {
+        throw std::invalid_argument("Corrupted kill log file");
+    }
+
+    // Columns are encoded as 64-bit values; signed fields are sign-extended so
+    // that deltas between them stay small.
+    std::uint64_t field(const KillEvent& event, int column)
+    {
+        switch (column)
+        {
+            case ROUND: return event.round;
+            case RADIUS: return event.radius;
+            case KILLER: return static_cast<std::uint64_t>(event.killer);
+            case VICTIM: return static_cast<std::uint64_t>(event.victim);
+            case KILLER_ID: return event.killer_id;
+            case VICTIM_ID: return event.victim_id;
+            case KILLER_X: return static_cast<std::uint64_t>(std::int64_t(event.killer_x));
+            case KILLER_Y: return static_cast<std::uint64_t>(std::int64_t(event.killer_y));
+            case VICTIM_X: return static_cast<std::uint64_t>(std::int64_t(event.victim_x));
+            default: return static_cast<std::uint64_t>(std::int64_t(event.victim_y));
+        }
+    }
+
+    void set_field(KillEvent& event, int column, std::uint64_t value, std::span<const NPCType> types)
+    {
+        switch (column)
+        {
+            case ROUND: event.round = static_cast<std::uint32_t>(value); break;
+            case RADIUS: event.radius = value; break;
+            case KILLER:
+            case VICTIM:
+            {
+                if (value >= types.size())
+                {
+                    corrupted();
+                }
+                (column == KILLER ? event.killer : event.victim) = types[value];
+                break;
+            }
+            case KILLER_ID: event.killer_id = static_cast<std::uint32_t>(value); break;
+            case VICTIM_ID: event.victim_id = static_cast<std::uint32_t>(value); break;
+            case KILLER_X: event.killer_x = static_cast<int>(value); break;
+            case KILLER_Y: event.killer_y = static_cast<int>(value); break;
+            case VICTIM_X: event.victim_x = static_cast<int>(value); break;
+            default: event.victim_y = static_cast<int>(value); break;
+        }
+    }
+
+    void put_varint(std::vector<char>& out, std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    std::uint64_t get_varint(const char*& at, const char* end)
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            if (at == end)
+            {
+                corrupted();
+            }
+            const auto byte = static_cast<std::uint8_t>(*at++);
+            value |= std::uint64_t(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+        corrupted();
+        return 0;
+    }
+
+    void write_names(std::ostream& out, size_t first, size_t last)
+    {
+        for (size_t code = first; code < last; ++code)
+        {
+            const std::string_view name = TypeRegistry::name(static_cast<NPCType>(code));
+            const auto length = static_cast<std::uint16_t>(name.size());
+            out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.write(name.data(), static_cast<std::streamsize>(name.size()));
+        }
+    }
+
+    size_t names_bytes(size_t first, size_t last)
+    {
+        size_t bytes = 0;
+        for (size_t code = first; code < last; ++code)
+        {
+            bytes += sizeof(std::uint16_t) + TypeRegistry::name(static_cast<NPCType>(code)).size();
+        }
+        return bytes;
+    }
+
+    // Registers count names stored in [at, end) and appends their types.
+    void read_names(const char* at, const char* end, std::uint32_t count, std::vector<NPCType>& types)
+    {
+        if (types.size() + count > MAX_NPC_TYPES)
+        {
+            corrupted();
+        }
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            std::uint16_t length = 0;
+            if (static_cast<size_t>(end - at) < sizeof(length))
+            {
+                corrupted();
+            }
+            std::memcpy(&length, at, sizeof(length));
+            at += sizeof(length);
+            if (static_cast<size_t>(end - at) < length)
+            {
+                corrupted();
+            }
+            types.push_back(TypeRegistry::add(std::string_view(at, length)));
+            at += length;
+        }
+        if (at != end)
+        {
+            corrupted();
+        }
+    }
+
+    // Reads and checks the header of the chunk at offset; returns the offset
+    // of the next chunk.
+    size_t read_chunk_header(const MappedFile& mapping, size_t offset, ChunkHeader& header)
+    {
+        if (mapping.size() - offset < sizeof(header))
+        {
+            corrupted();
+        }
+        std::memcpy(&header, mapping.data() + offset, sizeof(header));
+        if (std::memcmp(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0)
+        {
+            corrupted();
+        }
+        size_t end = offset + sizeof(header) + header.added_bytes;
+        for (std::uint32_t bytes : header.column_bytes)
+        {
+            end += bytes;
+        }
+        if (end > mapping.size() || header.count > header.column_bytes[ROUND])
+        {
+            corrupted();
+        }
+        return end;
+    }
+
+    std::uint64_t zigzag(std::uint64_t delta)
+    {
+        return (delta << 1) ^ static_cast<std::uint64_t>(static_cast<std::int64_t>(delta) >> 63);
+    }
+
+    std::uint64_t unzigzag(std::uint64_t value)
+    {
+        return (value >> 1) ^ (~(value & 1) + 1);
+    }
+}
+
+KillLogObserver::KillLogObserver(const std::string& path) : file(path, std::ios::binary | std::ios::trunc)
+{
+    if (!file.is_open())
+    {
+        throw std::invalid_argument("Unable to save data to file");
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, KillLog::MAGIC, sizeof(KillLog::MAGIC));
+    header.version = KillLog::VERSION;
+    written_types = TypeRegistry::count();
+    header.type_count = static_cast<std::uint32_t>(written_types);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_names(file, 0, written_types);
+    pending.reserve(KillLog::CHUNK);
+}
+
+KillLogObserver::~KillLogObserver()
+{
+    flush();
+}
+
+void KillLogObserver::on_kill(const KillEvent& event)
+{
+    pending.push_back(event);
+    if (pending.size() == KillLog::CHUNK)
+    {
+        write_chunk();
+    }
+}
+
+void KillLogObserver::flush()
+{
+    if (!pending.empty())
+    {
+        write_chunk();
+    }
+    file.flush();
+}
+
+void KillLogObserver::write_chunk()
+{
+    ChunkHeader header{};
+    std::memcpy(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+    header.count = static_cast<std::uint32_t>(pending.size());
+    header.first_round = header.last_round = pending.front().round;
+    header.min_x = header.max_x = pending.front().victim_x;
+    header.min_y = header.max_y = pending.front().victim_y;
+    for (const KillEvent& event : pending)
+    {
+        header.first_round = std::min(header.first_round, event.round);
+        header.last_round = std::max(header.last_round, event.round);
+        header.min_x = std::min(header.min_x, event.victim_x);
+        header.max_x = std::max(header.max_x, event.victim_x);
+        header.min_y = std::min(header.min_y, event.victim_y);
+        header.max_y = std::max(header.max_y, event.victim_y);
+        header.killers |= type_mask(event.killer);
+        header.victims |= type_mask(event.victim);
+    }
+
+    std::vector<char> body;
+    for (int column = 0; column < COLUMNS; ++column)
+    {
+        const size_t begin = body.size();
+        std::uint64_t previous = 0;
+        for (const KillEvent& event : pending)
+        {
+            const std::uint64_t value = field(event, column);
+            put_varint(body, zigzag(value - previous));
+            previous = value;
+        }
+        header.column_bytes[column] = static_cast<std::uint32_t>(body.size() - begin);
+    }
+
+    const size_t types = TypeRegistry::count();
+    header.added_types = static_cast<std::uint32_t>(types - written_types);
+    header.added_bytes = static_cast<std::uint32_t>(names_bytes(written_types, types));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_names(file, written_types, types);
+    file.write(body.data(), static_cast<std::streamsize>(body.size()));
+    written_types = types;
+    pending.clear();
+}
+
+bool KillLogFilter::matches(const KillEvent& event) const
+{
+    return event.round >= first_round && event.round <= last_round &&
+           event.victim_x >= min_x && event.victim_x <= max_x &&
+           event.victim_y >= min_y && event.victim_y <= max_y &&
+           (type_mask(event.killer) & killers) != 0 && (type_mask(event.victim) & victims) != 0;
+}
+
+KillLogReader::KillLogReader(const std::string& filename) : mapping(filename)
+{
+    FileHeader header{};
+    if (mapping.size() < sizeof(header))
+    {
+        corrupted();
+    }
+    std::memcpy(&header, mapping.data(), sizeof(header));
+    if (std::memcmp(header.magic, KillLog::MAGIC, sizeof(KillLog::MAGIC)) != 0)
+    {
+        corrupted();
+    }
+    if (header.version != KillLog::VERSION)
+    {
+        throw std::invalid_argument("Unsupported kill log version");
+    }
+    if (header.type_count > MAX_NPC_TYPES)
+    {
+        corrupted();
+    }
+
+    // The names' bytes are bounded by the first chunk, or the end of the file.
+    size_t offset = sizeof(header);
+    size_t names_end = offset;
+    for (std::uint32_t i = 0; i < header.type_count; ++i)
+    {
+        std::uint16_t length = 0;
+        if (mapping.size() - names_end < sizeof(length))
+        {
+            corrupted();
+        }
+        std::memcpy(&length, mapping.data() + names_end, sizeof(length));
+        names_end += sizeof(length) + length;
+        if (names_end > mapping.size())
+        {
+            corrupted();
+        }
+    }
+    read_names(mapping.data() + offset, mapping.data() + names_end, header.type_count, types);
+    header_types = types.size();
+    first_chunk = offset = names_end;
+
+    while (offset < mapping.size())
+    {
+        ChunkHeader chunk{};
+        const size_t next = read_chunk_header(mapping, offset, chunk);
+        const char* names = mapping.data() + offset + sizeof(chunk);
+        read_names(names, names + chunk.added_bytes, chunk.added_types, types);
+        offset = next;
+        ++chunks;
+    }
+}
+
+size_t KillLogReader::scan(const KillLogFilter& filter, const std::function<void(const KillEvent&)>& visit) const
+{
+    size_t decoded = 0;
+    std::vector<KillEvent> events;
+    // Codes a chunk may use: the header dictionary plus every addition so far.
+    size_t known = header_types;
+    for (size_t offset = first_chunk; offset < mapping.size(); )
+    {
+        ChunkHeader header{};
+        const size_t next = read_chunk_header(mapping, offset, header);
+        const char* at = mapping.data() + offset + sizeof(header) + header.added_bytes;
+        offset = next;
+        known += header.added_types;
+        if (known > types.size())
+        {
+            corrupted();
+        }
+
+        const std::uint64_t codes = known == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << known) - 1;
+        if (((header.killers | header.victims) & ~codes) != 0)
+        {
+            corrupted();
+        }
+        std::uint64_t killers = 0;
+        std::uint64_t victims = 0;
+        for (size_t code = 0; code < known; ++code)
+        {
+            killers |= ((header.killers >> code) & 1) ? type_mask(types[code]) : 0;
+            victims |= ((header.victims >> code) & 1) ? type_mask(types[code]) : 0;
+        }
+        if (header.last_round < filter.first_round || header.first_round > filter.last_round ||
+            header.max_x < filter.min_x || header.min_x > filter.max_x ||
+            header.max_y < filter.min_y || header.min_y > filter.max_y ||
+            (killers & filter.killers) == 0 || (victims & filter.victims) == 0)
+        {
+            continue;
+        }
+
+        events.assign(header.count, KillEvent{});
+        const std::span<const NPCType> dictionary(types.data(), known);
+        for (int column = 0; column < COLUMNS; ++column)
+        {
+            const char* end = at + header.column_bytes[column];
+            std::uint64_t value = 0;
+            for (KillEvent& event : events)
+            {
+                value += unzigzag(get_varint(at, end));
+                set_field(event, column, value, dictionary);
+            }
+            if (at != end)
+            {
+                corrupted();
+            }
+        }
+        ++decoded;
+
+        for (const KillEvent& event : events)
+        {
+            if (filter.matches(event))
+            {
+                visit(event);
+            }
+        }
+    }
+    return decoded;
+}
+
+size_t KillLogReader::chunk_count() const
+{
+    return chunks;
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "MappedLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    // Unmaps the window and trims the file to size before closing it.
+    void finish(int fd, char* window, size_t size)
+    {
+        if (window != nullptr)
+        {
+            munmap(window, MappedLog::CHUNK);
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+        {
+            fdatasync(fd);
+        }
+        close(fd);
+    }
+}
+
+MappedLog::MappedLog(const std::string& path) : path(path)
+{
+    open_file();
+}
+
+MappedLog::~MappedLog()
+{
+    close_file();
+}
+
+void MappedLog::sync()
+{
+    if (fdatasync(fd) != 0)
+    {
+        throw std::invalid_argument("Unable to save data to file");
+    }
+}
+
+void MappedLog::rotate()
+{
+    std::string target;
+    do
+    {
+        target = path + '.' + std::to_string(++rotations);
+    }
+    while (std::filesystem::exists(target));
+    std::filesystem::rename(path, target);
+
+    // The old file stays open, locked and mapped until the new one is ready,
+    // so a failed rotation puts it back and leaves the log writing where it was.
+    const int old_fd = fd;
+    char* const old_window = window;
+    const size_t old_base = base;
+    const size_t old_used = used;
+    try
+    {
+        open_file();
+    }
+    catch (...)
+    {
+        fd = old_fd;
+        window = old_window;
+        base = old_base;
+        used = old_used;
+        std::error_code ignored;
+        std::filesystem::rename(target, path, ignored);
+        throw;
+    }
+    finish(old_fd, old_window, old_base + old_used);
+}
+
+size_t MappedLog::size() const
+{
+    return base + used;
+}
+
+const std::string& MappedLog::get_path() const
+{
+    return path;
+}
+
+void MappedLog::open_file()
+{
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        throw std::invalid_argument("Unable to save data to file");
+    }
+
+    try
+    {
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+        {
+            throw std::runtime_error("Log file is in use");
+        }
+        map_chunk(logical_size());
+    }
+    catch (...)
+    {
+        close(fd);
+        fd = -1;
+        throw;
+    }
+}
+
+// A log that was not closed still ends in the zeros of its last chunk, which
+// is never more than CHUNK bytes. Text logs hold no zero bytes, so the data
+// ends at the last non-zero byte.
+size_t MappedLog::logical_size() const
+{
+    struct stat info{};
+    if (fstat(fd, &info) != 0)
+    {
+        throw std::invalid_argument("Unable to save data to file");
+    }
+
+    constexpr size_t BLOCK = 1 << 16;
+    char block[BLOCK];
+    const auto end = static_cast<size_t>(info.st_size);
+    const size_t limit = end > CHUNK ? end - CHUNK : 0;
+    for (size_t at = end; at > limit; )
+    {
+        const size_t count = std::min(BLOCK, at - limit);
+        at -= count;
+        if (pread(fd, block, count, static_cast<off_t>(at)) != static_cast<ssize_t>(count))
+        {
+            throw std::invalid_argument("Unable to save data to file");
+        }
+        for (size_t i = count; i > 0; --i)
+        {
+            if (block[i - 1] != '\0')
+            {
+                return at + i;
+            }
+        }
+    }
+    return limit;
+}
+
+void MappedLog::close_file()
+{
+    if (fd < 0)
+    {
+        return;
+    }
+    finish(fd, window, size());
+    window = nullptr;
+    fd = -1;
+}
+
+// Maps the chunk holding offset, preallocating it so that running out of disk
+// space is reported here rather than as SIGBUS on a later write.
+void MappedLog::map_chunk(size_t offset)
+{
+    const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t start = offset / page * page;
+    const int error = posix_fallocate(fd, static_cast<off_t>(start), static_cast<off_t>(CHUNK));
+    if (error != 0 && (error != EOPNOTSUPP || ftruncate(fd, static_cast<off_t>(start + CHUNK)) != 0))
+    {
+        throw std::invalid_argument("Unable to save data to file");
+    }
+
+    void* mapping = mmap(nullptr, CHUNK, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(start));
+    if (mapping == MAP_FAILED)
+    {
+        throw std::invalid_argument("Unable to save data to file");
+    }
+    madvise(mapping, CHUNK, MADV_SEQUENTIAL);
+    window = static_cast<char*>(mapping);
+    base = start;
+    used = offset - start;
+}
+
+void MappedLog::append_slow(std::string_view text)
+{
+    while (!text.empty())
+    {
+        if (used == CHUNK)
+        {
+            // The full chunk stays mapped if the next one cannot be.
+            char* const full = window;
+            map_chunk(base + CHUNK);
+            munmap(full, CHUNK);
+        }
+        const size_t count = std::min(text.size(), CHUNK - used);
+        std::memcpy(window + used, text.data(), count);
+        used += count;
+        text.remove_prefix(count);
+    }
+}
\ No newline at end of file
@@ -1,11 +1,38 @@
 #include "NPC.h"
 #include <Visitor.h>
+#include <climits>
+#include "TypeRegistry.h"
 
 NPC::NPC(int x, int y) : x(x), y(y) {}
 
+std::string_view NPC::get_type() const
+{
+    return TypeRegistry::name(get_type_id());
+}
+
 bool NPC::is_close(const NPC& other, size_t distance) const
 {
-    return (x - other.x) * (x - other.x) + (y - other.y) * (y - other.y) <= distance * distance;
+    return is_close(x, y, other.x, other.y, distance);
+}
+
+bool NPC::is_close(int x1, int y1, int x2, int y2, size_t distance)
+{
+    return squared_distance(x1, y1, x2, y2) <= squared_radius(distance);
+}
+
+unsigned long long NPC::squared_distance(int x1, int y1, int x2, int y2)
+{
+    const long long dx = static_cast<long long>(x1) - x2;
+    const long long dy = static_cast<long long>(y1) - y2;
+    const unsigned long long ax = dx < 0 ? -dx : dx;
+    const unsigned long long ay = dy < 0 ? -dy : dy;
+    const unsigned long long sum = ax * ax + ay * ay;
+    return sum < ax * ax ? ULLONG_MAX : sum;
+}
+
+unsigned long long NPC::squared_radius(size_t distance)
+{
+    return distance > UINT_MAX ? ULLONG_MAX : static_cast<unsigned long long>(distance) * distance;
 }
 
 Dragon::Dragon(int x, int y) : NPC(x, y) {}
@@ -15,9 +42,9 @@ void Dragon::accept(INPCVisitor& visitor)
     visitor.try_to_kill(*this);
 }
 
-std::string Dragon::get_type() const
+NPCType Dragon::get_type_id() const
 {
-    return "Dragon";
+    return TYPE_ID;
 }
 
 Frog::Frog(int x, int y) : NPC(x, y) {}
@@ -27,9 +54,9 @@ void Frog::accept(INPCVisitor& visitor)
     visitor.try_to_kill(*this);
 }
 
-std::string Frog::get_type() const
+NPCType Frog::get_type_id() const
 {
-    return "Frog";
+    return TYPE_ID;
 }
 
 Knight::Knight(int x, int y) : NPC(x, y) {}
@@ -39,7 +66,19 @@ void Knight::accept(INPCVisitor& visitor)
     visitor.try_to_kill(*this);
 }
 
-std::string Knight::get_type() const
+NPCType Knight::get_type_id() const
+{
+    return TYPE_ID;
+}
+
+CustomNPC::CustomNPC(NPCType type, int x, int y) : NPC(x, y), type(type) {}
+
+void CustomNPC::accept(INPCVisitor& visitor)
+{
+    visitor.try_to_kill(*this);
+}
+
+NPCType CustomNPC::get_type_id() const
 {
-    return "Knight";
+    return type;
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "NPCPool.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr size_t FIRST_CHUNK_BLOCKS = 64;
+    constexpr size_t MAX_CHUNK_BLOCKS = 4096;
+}
+
+void* NPCPool::State::allocate(std::type_index type, size_t size, size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Slab& slab = slab_for(type, size, alignment);
+    ++allocation_count;
+
+    if (slab.free_list != nullptr)
+    {
+        void* block = slab.free_list;
+        slab.free_list = *static_cast<void**>(block);
+        return block;
+    }
+
+    if (slab.cursor == slab.limit)
+    {
+        const size_t bytes = slab.block_size * slab.next_chunk_blocks;
+        chunks.push_back(std::make_unique<char[]>(bytes + alignof(std::max_align_t)));
+        char* raw = chunks.back().get();
+        const auto misalignment = reinterpret_cast<std::uintptr_t>(raw) % alignof(std::max_align_t);
+        slab.cursor = misalignment == 0 ? raw : raw + (alignof(std::max_align_t) - misalignment);
+        slab.limit = slab.cursor + bytes;
+        slab.next_chunk_blocks = std::min(slab.next_chunk_blocks * 2, MAX_CHUNK_BLOCKS);
+    }
+
+    void* block = slab.cursor;
+    slab.cursor += slab.block_size;
+    return block;
+}
+
+void NPCPool::State::deallocate(std::type_index type, void* block)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Slab& slab : slabs)
+    {
+        if (slab.type == type)
+        {
+            *static_cast<void**>(block) = slab.free_list;
+            slab.free_list = block;
+            return;
+        }
+    }
+}
+
+size_t NPCPool::State::allocations()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return allocation_count;
+}
+
+size_t NPCPool::State::upstream_allocations()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return chunks.size();
+}
+
+NPCPool::State::Slab& NPCPool::State::slab_for(std::type_index type, size_t size, size_t alignment)
+{
+    for (Slab& slab : slabs)
+    {
+        if (slab.type == type)
+        {
+            return slab;
+        }
+    }
+
+    const size_t align = std::max(alignment, alignof(void*));
+    const size_t block_size = (std::max(size, sizeof(void*)) + align - 1) / align * align;
+    slabs.push_back(Slab{type, block_size, FIRST_CHUNK_BLOCKS, nullptr, nullptr, nullptr});
+    return slabs.back();
+}
+
+void NPCPool::release()
+{
+    state = std::make_shared<State>();
+}
+
+size_t NPCPool::allocations() const
+{
+    return state->allocations();
+}
+
+size_t NPCPool::upstream_allocations() const
+{
+    return state->upstream_allocations();
+}
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "NPCStore.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include "Factory.h"
+
+namespace
+{
+    // Handles of buried NPCs map to a graveyard slot tagged with this bit.
+    constexpr std::uint32_t BURIED = 0x80000000u;
+}
+
+NPCHandle NPCStore::add(NPCType type, int x, int y)
+{
+    if (indices.size() >= BURIED)
+    {
+        throw std::length_error("NPC store is full");
+    }
+
+    const auto index = static_cast<std::uint32_t>(xs.size());
+    const auto id = static_cast<std::uint32_t>(indices.size());
+    xs.push_back(x);
+    ys.push_back(y);
+    types.push_back(type);
+    if (index % 64 == 0)
+    {
+        alive.push_back(0);
+    }
+    alive[index / 64] |= std::uint64_t(1) << (index % 64);
+    ++alive_total;
+    handles.push_back(id);
+    indices.push_back(index);
+    return NPCHandle{id};
+}
+
+NPCHandle NPCStore::append(std::span<const int> x, std::span<const int> y, std::span<const NPCType> type,
+                           std::span<const std::uint64_t> alive_bits)
+{
+    const size_t count = x.size();
+    if (y.size() != count || type.size() != count)
+    {
+        throw std::invalid_argument("Column sizes differ");
+    }
+    if (!alive_bits.empty() && alive_bits.size() < (count + 63) / 64)
+    {
+        throw std::invalid_argument("Alive bitset is too short");
+    }
+    if (count > BURIED - indices.size())
+    {
+        throw std::length_error("NPC store is full");
+    }
+
+    const size_t base = xs.size();
+    const size_t first_id = indices.size();
+    // Grow geometrically so that many small appends stay amortised linear.
+    if (base + count > xs.capacity())
+    {
+        reserve(std::max(base + count, 2 * xs.capacity()));
+    }
+    xs.insert(xs.end(), x.begin(), x.end());
+    ys.insert(ys.end(), y.begin(), y.end());
+    types.insert(types.end(), type.begin(), type.end());
+    for (size_t k = 0; k < count; ++k)
+    {
+        handles.push_back(static_cast<std::uint32_t>(first_id + k));
+        indices.push_back(static_cast<std::uint32_t>(base + k));
+    }
+
+    alive.resize((base + count + 63) / 64, 0);
+    if (base % 64 == 0)
+    {
+        for (size_t word = 0; word * 64 < count; ++word)
+        {
+            std::uint64_t bits = alive_bits.empty() ? ~std::uint64_t(0) : alive_bits[word];
+            if (count - word * 64 < 64)
+            {
+                bits &= (std::uint64_t(1) << (count - word * 64)) - 1;
+            }
+            alive[base / 64 + word] = bits;
+            alive_total += std::popcount(bits);
+        }
+        return NPCHandle{static_cast<std::uint32_t>(first_id)};
+    }
+    for (size_t k = 0; k < count; ++k)
+    {
+        if (alive_bits.empty() || ((alive_bits[k / 64] >> (k % 64)) & 1))
+        {
+            alive[(base + k) / 64] |= std::uint64_t(1) << ((base + k) % 64);
+            ++alive_total;
+        }
+    }
+    return NPCHandle{static_cast<std::uint32_t>(first_id)};
+}
+
+void NPCStore::reserve(size_t count)
+{
+    xs.reserve(count);
+    ys.reserve(count);
+    types.reserve(count);
+    alive.reserve((count + 63) / 64);
+    handles.reserve(count);
+    indices.reserve(count);
+}
+
+void NPCStore::clear()
+{
+    xs.clear();
+    ys.clear();
+    types.clear();
+    alive.clear();
+    handles.clear();
+    indices.clear();
+    alive_total = 0;
+    graveyard.clear();
+}
+
+size_t NPCStore::size() const
+{
+    return xs.size();
+}
+
+size_t NPCStore::alive_count() const
+{
+    return alive_total;
+}
+
+int NPCStore::x(size_t index) const
+{
+    return xs[index];
+}
+
+int NPCStore::y(size_t index) const
+{
+    return ys[index];
+}
+
+NPCType NPCStore::type(size_t index) const
+{
+    return types[index];
+}
+
+bool NPCStore::is_alive(size_t index) const
+{
+    return (alive[index / 64] >> (index % 64)) & 1;
+}
+
+void NPCStore::kill(size_t index)
+{
+    const std::uint64_t bit = std::uint64_t(1) << (index % 64);
+    if (alive[index / 64] & bit)
+    {
+        alive[index / 64] &= ~bit;
+        --alive_total;
+    }
+}
+
+std::vector<std::uint32_t> NPCStore::compact()
+{
+    std::vector<std::uint32_t> remap(xs.size(), NO_INDEX);
+    size_t next = 0;
+    for (size_t i = 0; i < xs.size(); ++i)
+    {
+        if (!is_alive(i))
+        {
+            indices[handles[i]] = BURIED | static_cast<std::uint32_t>(graveyard.size());
+            graveyard.push_back(NPCRecord{NPCHandle{handles[i]}, types[i], xs[i], ys[i], false});
+            continue;
+        }
+        remap[i] = static_cast<std::uint32_t>(next);
+        xs[next] = xs[i];
+        ys[next] = ys[i];
+        types[next] = types[i];
+        handles[next] = handles[i];
+        indices[handles[next]] = static_cast<std::uint32_t>(next);
+        ++next;
+    }
+
+    xs.resize(next);
+    ys.resize(next);
+    types.resize(next);
+    handles.resize(next);
+    alive.assign((next + 63) / 64, ~std::uint64_t(0));
+    if (next % 64 != 0)
+    {
+        alive.back() = (std::uint64_t(1) << (next % 64)) - 1;
+    }
+    return remap;
+}
+
+size_t NPCStore::dead_count() const
+{
+    return xs.size() - alive_total;
+}
+
+const std::vector<NPCRecord>& NPCStore::get_graveyard() const
+{
+    return graveyard;
+}
+
+const std::vector<int>& NPCStore::get_xs() const
+{
+    return xs;
+}
+
+const std::vector<int>& NPCStore::get_ys() const
+{
+    return ys;
+}
+
+const std::vector<NPCType>& NPCStore::get_types() const
+{
+    return types;
+}
+
+const std::vector<std::uint64_t>& NPCStore::get_alive_bits() const
+{
+    return alive;
+}
+
+NPCHandle NPCStore::handle(size_t index) const
+{
+    return NPCHandle{handles.at(index)};
+}
+
+size_t NPCStore::index_of(NPCHandle handle) const
+{
+    if (is_buried(handle))
+    {
+        throw std::invalid_argument("NPC has been compacted away");
+    }
+    return indices[handle.id];
+}
+
+bool NPCStore::is_buried(NPCHandle handle) const
+{
+    return (indices.at(handle.id) & BURIED) != 0;
+}
+
+NPCRecord NPCStore::record(NPCHandle handle) const
+{
+    if (is_buried(handle))
+    {
+        return graveyard[indices[handle.id] & ~BURIED];
+    }
+    const size_t index = indices[handle.id];
+    return NPCRecord{handle, types[index], xs[index], ys[index], is_alive(index)};
+}
+
+std::shared_ptr<NPC> NPCStore::view(size_t index) const
+{
+    auto npc = INPCFactory::create_npc(types.at(index), xs[index], ys[index]);
+    npc->is_alive = is_alive(index);
+    return npc;
+}
+
+std::shared_ptr<NPC> NPCStore::view(size_t index, NPCPool& pool) const
+{
+    auto npc = INPCFactory::create_npc(types.at(index), xs[index], ys[index], pool);
+    npc->is_alive = is_alive(index);
+    return npc;
+}
\ No newline at end of file
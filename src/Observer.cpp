@@ -1,15 +1,65 @@
 #include "Observer.h"
 
 #include <iostream>
+#include "BufferedWriter.h"
+#include "TypeRegistry.h"
 
-void IConsoleObserver::msg_kill(const std::string& killer, const std::string& victim)
+namespace
 {
-    std::cout << killer << " killed " << victim << std::endl;
+    void write_kills(std::ostream& out, std::span<const KillEvent> events)
+    {
+        BufferedWriter writer(out);
+        for (const KillEvent& event : events)
+        {
+            writer << TypeRegistry::name(event.killer) << " killed " << TypeRegistry::name(event.victim) << '\n';
+        }
+    }
+}
+
+void IObserver::on_round_begin(std::uint32_t, std::uint64_t) {}
+
+void IObserver::on_round(std::span<const KillEvent> events)
+{
+    for (const KillEvent& event : events)
+    {
+        on_kill(event);
+    }
+}
+
+void IObserver::on_round_end(std::uint32_t)
+{
+    flush();
+}
+
+void IObserver::on_kill(const KillEvent& event)
+{
+    msg_kill(std::string(TypeRegistry::name(event.killer)), std::string(TypeRegistry::name(event.victim)));
+}
+
+void IObserver::msg_kill(const std::string&, const std::string&) {}
+
+void IObserver::flush() {}
+
+IConsoleObserver::IConsoleObserver(std::ostream& out) : out(out) {}
+
+void IConsoleObserver::on_round(std::span<const KillEvent> events)
+{
+    write_kills(out, events);
+}
+
+void IConsoleObserver::on_kill(const KillEvent& event)
+{
+    out << TypeRegistry::name(event.killer) << " killed " << TypeRegistry::name(event.victim) << '\n';
 }
 
-FileObserver::FileObserver()
+void IConsoleObserver::flush()
 {
-    file.open("../logs.txt", std::ios::app);
+    out.flush();
+}
+
+FileObserver::FileObserver(const std::string& path)
+{
+    file.open(path, std::ios::app);
 }
 
 FileObserver::~FileObserver()
@@ -20,10 +70,87 @@ FileObserver::~FileObserver()
     }
 }
 
-void FileObserver::msg_kill(const std::string& killer, const std::string& victim)
+void FileObserver::on_round(std::span<const KillEvent> events)
+{
+    if (file.is_open())
+    {
+        write_kills(file, events);
+    }
+}
+
+void FileObserver::on_kill(const KillEvent& event)
 {
     if (file.is_open())
     {
-        file << killer << " killed " << victim << std::endl;
+        file << TypeRegistry::name(event.killer) << " killed " << TypeRegistry::name(event.victim) << '\n';
+    }
+}
+
+void FileObserver::flush()
+{
+    if (file.is_open())
+    {
+        file.flush();
+    }
+}
+
+MappedLogObserver::MappedLogObserver(const std::string& path, size_t rotate_bytes,
+                                     std::chrono::milliseconds sync_interval) :
+                                     rotate_bytes(rotate_bytes), sync_interval(sync_interval), last_sync(Clock::now())
+{
+    try
+    {
+        log = std::make_unique<MappedLog>(path);
+    }
+    catch (const std::invalid_argument&) {}
+}
+
+void MappedLogObserver::on_round(std::span<const KillEvent> events)
+{
+    if (log)
+    {
+        for (const KillEvent& event : events)
+        {
+            write(event);
+        }
+    }
+}
+
+void MappedLogObserver::on_round_end(std::uint32_t)
+{
+    if (log && Clock::now() - last_sync >= sync_interval)
+    {
+        flush();
+    }
+}
+
+void MappedLogObserver::on_kill(const KillEvent& event)
+{
+    if (log)
+    {
+        write(event);
+    }
+}
+
+void MappedLogObserver::flush()
+{
+    if (log)
+    {
+        log->sync();
+        last_sync = Clock::now();
+    }
+}
+
+bool MappedLogObserver::is_open() const
+{
+    return log != nullptr;
+}
+
+void MappedLogObserver::write(const KillEvent& event)
+{
+    *log << TypeRegistry::name(event.killer) << " killed " << TypeRegistry::name(event.victim) << '\n';
+    if (rotate_bytes != 0 && log->size() >= rotate_bytes)
+    {
+        log->rotate();
     }
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "PairQueue.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include "NPC.h"
+#include "NPCStore.h"
+
+PairQueue::PairQueue(const std::vector<int>& xs, const std::vector<int>& ys, const RadiusSchedule& schedule,
+                     SpatialIndexKind index)
+{
+    if (xs.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::invalid_argument("Too many NPCs for a pair queue");
+    }
+
+    const size_t rounds = schedule.rounds();
+    band_start.assign(rounds + 1, 0);
+    if (rounds == 0 || xs.empty())
+    {
+        return;
+    }
+
+    std::vector<unsigned long long> limits;
+    limits.reserve(rounds);
+    for (size_t radius : schedule.get_radii())
+    {
+        limits.push_back(NPC::squared_radius(radius));
+    }
+
+    const std::unique_ptr<ISpatialIndex> spatial = SpatialIndex::build(index, xs, ys, schedule.max_radius());
+    std::vector<size_t> neighbours;
+    std::vector<NPCPair> found;
+    std::vector<std::uint32_t> bands;
+
+    for (size_t i = 0; i < xs.size(); ++i)
+    {
+        neighbours.clear();
+        tests += spatial->query(xs[i], ys[i], schedule.max_radius(), neighbours);
+        std::sort(neighbours.begin(), neighbours.end());
+
+        for (size_t j : neighbours)
+        {
+            if (i == j)
+            {
+                continue;
+            }
+            const unsigned long long distance = NPC::squared_distance(xs[i], ys[i], xs[j], ys[j]);
+            const size_t round = std::lower_bound(limits.begin(), limits.end(), distance) - limits.begin();
+            found.push_back({static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j)});
+            bands.push_back(static_cast<std::uint32_t>(round));
+            ++band_start[round + 1];
+        }
+    }
+
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        band_start[round + 1] += band_start[round];
+    }
+
+    pairs.resize(found.size());
+    std::vector<size_t> fill(band_start.begin(), band_start.end() - 1);
+    for (size_t k = 0; k < found.size(); ++k)
+    {
+        pairs[fill[bands[k]]++] = found[k];
+    }
+}
+
+std::span<const NPCPair> PairQueue::band(size_t round) const
+{
+    return std::span<const NPCPair>(pairs).subspan(band_start.at(round), band_start.at(round + 1) - band_start.at(round));
+}
+
+size_t PairQueue::rounds() const
+{
+    return band_start.size() - 1;
+}
+
+size_t PairQueue::size() const
+{
+    return pairs.size();
+}
+
+void PairQueue::compact(std::span<const std::uint32_t> remap, size_t first_round)
+{
+    size_t begin = band_start.at(first_round);
+    size_t out = 0;
+    for (size_t round = 0; round < first_round; ++round)
+    {
+        band_start[round] = 0;
+    }
+    for (size_t round = first_round; round < rounds(); ++round)
+    {
+        const size_t end = band_start[round + 1];
+        band_start[round] = out;
+        for (size_t k = begin; k < end; ++k)
+        {
+            const std::uint32_t attacker = remap[pairs[k].attacker];
+            const std::uint32_t defender = remap[pairs[k].defender];
+            if (attacker != NPCStore::NO_INDEX && defender != NPCStore::NO_INDEX)
+            {
+                pairs[out++] = NPCPair{attacker, defender};
+            }
+        }
+        begin = end;
+    }
+    band_start.back() = out;
+    pairs.resize(out);
+}
+
+std::uint64_t PairQueue::distance_tests() const
+{
+    return tests;
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "PopulationGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "TypeRegistry.h"
+
+namespace
+{
+    // SplitMix64 finaliser; spreads neighbouring block indices over unrelated seeds.
+    std::uint64_t mix(std::uint64_t z)
+    {
+        z += 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    std::mt19937_64 stream(unsigned long long seed, std::uint64_t index)
+    {
+        return std::mt19937_64(mix(seed ^ mix(index)));
+    }
+
+    int to_coordinate(double value)
+    {
+        constexpr double low = std::numeric_limits<int>::min();
+        constexpr double high = std::numeric_limits<int>::max();
+        return static_cast<int>(std::clamp(value, low, high));
+    }
+
+    std::vector<double> type_weights(const PopulationSpec& spec)
+    {
+        if (spec.type_weights.empty())
+        {
+            return std::vector<double>(NPC_TYPE_COUNT, 1.0);
+        }
+        if (spec.type_weights.size() > TypeRegistry::count())
+        {
+            throw std::invalid_argument("Unknown type");
+        }
+        double total = 0;
+        for (double weight : spec.type_weights)
+        {
+            if (!(weight >= 0) || std::isinf(weight))
+            {
+                throw std::invalid_argument("Type weights must be finite and non-negative");
+            }
+            total += weight;
+        }
+        if (total <= 0)
+        {
+            throw std::invalid_argument("Type weights must not all be zero");
+        }
+        return spec.type_weights;
+    }
+}
+
+Population PopulationGenerator::generate(const PopulationSpec& spec, ThreadPool& pool)
+{
+    if (spec.extent < 0 || !std::isfinite(spec.extent) || spec.spread < 0 || !std::isfinite(spec.spread))
+    {
+        throw std::invalid_argument("Extent and spread must be finite and non-negative");
+    }
+    const std::vector<double> weights = type_weights(spec);
+    const double count = static_cast<double>(spec.count);
+    const double extent = spec.extent > 0 ? spec.extent
+                        : spec.distribution == Distribution::Line ? count * 10.0 : std::sqrt(count) * 40.0;
+
+    // Cluster centres come from stream 0, blocks from streams 1 and up.
+    std::vector<std::pair<double, double>> centres;
+    if (spec.distribution == Distribution::Clustered)
+    {
+        std::mt19937_64 random = stream(spec.seed, 0);
+        std::uniform_real_distribution<double> coordinate(-extent / 2, extent / 2);
+        centres.resize(spec.clusters != 0 ? spec.clusters : std::max<size_t>(1, spec.count / 1000));
+        for (auto& [cx, cy] : centres)
+        {
+            cx = coordinate(random);
+            cy = coordinate(random);
+        }
+    }
+
+    Population population;
+    population.x.resize(spec.count);
+    population.y.resize(spec.count);
+    population.types.resize(spec.count);
+
+    const size_t blocks = (spec.count + BLOCK - 1) / BLOCK;
+    pool.run(blocks, [&](size_t block)
+    {
+        std::mt19937_64 random = stream(spec.seed, block + 1);
+        std::discrete_distribution<int> type(weights.begin(), weights.end());
+        std::uniform_real_distribution<double> coordinate(-extent / 2, extent / 2);
+        std::uniform_int_distribution<size_t> pick(0, centres.empty() ? 0 : centres.size() - 1);
+        // normal_distribution needs a positive deviation; a spread of 0
+        // places every NPC exactly on its centre.
+        std::normal_distribution<double> spread(0.0, spec.spread > 0 ? spec.spread : 1.0);
+        std::normal_distribution<double> across(0.0, 5.0);
+
+        const size_t end = std::min(spec.count, (block + 1) * BLOCK);
+        for (size_t i = block * BLOCK; i < end; ++i)
+        {
+            population.types[i] = static_cast<NPCType>(type(random));
+            switch (spec.distribution)
+            {
+                case Distribution::Uniform:
+                    population.x[i] = to_coordinate(coordinate(random));
+                    population.y[i] = to_coordinate(coordinate(random));
+                    break;
+                case Distribution::Clustered:
+                {
+                    const auto& [cx, cy] = centres[pick(random)];
+                    population.x[i] = to_coordinate(spec.spread > 0 ? cx + spread(random) : cx);
+                    population.y[i] = to_coordinate(spec.spread > 0 ? cy + spread(random) : cy);
+                    break;
+                }
+                case Distribution::Line:
+                    population.x[i] = to_coordinate(coordinate(random));
+                    population.y[i] = to_coordinate(across(random));
+                    break;
+            }
+        }
+    });
+    return population;
+}
+
+Population PopulationGenerator::generate(const PopulationSpec& spec)
+{
+    ThreadPool pool(1);
+    return generate(spec, pool);
+}
+
+Distribution PopulationGenerator::parse_distribution(std::string_view name)
+{
+    if (name == "uniform")
+    {
+        return Distribution::Uniform;
+    }
+    if (name == "clustered")
+    {
+        return Distribution::Clustered;
+    }
+    if (name == "line")
+    {
+        return Distribution::Line;
+    }
+    throw std::invalid_argument("Unknown distribution " + std::string(name));
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "RadiusSchedule.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+RadiusSchedule::RadiusSchedule(std::vector<size_t> radii) : radii(std::move(radii))
+{
+    if (!std::is_sorted(this->radii.begin(), this->radii.end()))
+    {
+        throw std::invalid_argument("Radius schedule must not decrease");
+    }
+}
+
+RadiusSchedule RadiusSchedule::linear(size_t distance, size_t step)
+{
+    if (step == 0)
+    {
+        throw std::invalid_argument("Radius step must be positive");
+    }
+
+    std::vector<size_t> radii;
+    radii.reserve(distance / step + 1);
+    for (size_t radius = 0; radius <= distance; radius += step)
+    {
+        radii.push_back(radius);
+        if (distance - radius < step)
+        {
+            break;
+        }
+    }
+    return RadiusSchedule(std::move(radii));
+}
+
+size_t RadiusSchedule::rounds() const
+{
+    return radii.size();
+}
+
+size_t RadiusSchedule::radius(size_t round) const
+{
+    return radii.at(round);
+}
+
+size_t RadiusSchedule::max_radius() const
+{
+    return radii.empty() ? 0 : radii.back();
+}
+
+const std::vector<size_t>& RadiusSchedule::get_radii() const
+{
+    return radii;
+}
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "RuleTable.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "KillTable.h"
+#include "MappedFile.h"
+#include "TextLoader.h"
+#include "TypeRegistry.h"
+
+namespace
+{
+    bool is_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // Splits one line into whitespace-separated tokens, dropping any comment.
+    std::vector<std::string_view> tokenize(std::string_view line)
+    {
+        line = line.substr(0, std::min(line.find('#'), line.size()));
+        std::vector<std::string_view> tokens;
+        size_t i = 0;
+        while (i < line.size())
+        {
+            while (i < line.size() && is_space(line[i]))
+            {
+                ++i;
+            }
+            const size_t begin = i;
+            while (i < line.size() && !is_space(line[i]))
+            {
+                ++i;
+            }
+            if (i != begin)
+            {
+                tokens.push_back(line.substr(begin, i - begin));
+            }
+        }
+        return tokens;
+    }
+
+    // Index of name among the names seen so far in the file, adding it if new.
+    size_t local_type(std::vector<std::string_view>& names, std::string_view name, size_t line)
+    {
+        if (!TypeRegistry::is_valid_name(name))
+        {
+            throw ParseError(line, "invalid type name '" + std::string(name) + "'");
+        }
+        const auto it = std::find(names.begin(), names.end(), name);
+        if (it != names.end())
+        {
+            return static_cast<size_t>(it - names.begin());
+        }
+        if (names.size() == MAX_NPC_TYPES)
+        {
+            throw ParseError(line, "too many types");
+        }
+        names.push_back(name);
+        return names.size() - 1;
+    }
+}
+
+const RuleTable& RuleTable::builtin()
+{
+    static const RuleTable table = []
+    {
+        RuleTable rules;
+        for (size_t a = 0; a < NPC_TYPE_COUNT; ++a)
+        {
+            rules.rows[a] = KillTable::victims_of(static_cast<NPCType>(a));
+        }
+        return rules;
+    }();
+    return table;
+}
+
+// The whole file is checked against names local to it before anything is
+// registered, so a file that fails to parse leaves the registry untouched.
+RuleTable RuleTable::parse(std::string_view text)
+{
+    std::vector<std::string_view> names;
+    size_t columns = 0;
+    // Kill flags per local attacker index, one bit per column.
+    std::vector<std::uint64_t> local_rows;
+    std::vector<bool> seen;
+    bool has_types = false;
+
+    size_t line = 0;
+    size_t cursor = 0;
+    while (cursor <= text.size())
+    {
+        ++line;
+        const size_t line_end = std::min(text.find('\n', cursor), text.size());
+        const std::vector<std::string_view> tokens = tokenize(text.substr(cursor, line_end - cursor));
+        cursor = line_end + 1;
+        if (tokens.empty())
+        {
+            continue;
+        }
+
+        if (!has_types)
+        {
+            if (tokens.front() != "types")
+            {
+                throw ParseError(line, "expected a 'types' line");
+            }
+            if (tokens.size() == 1)
+            {
+                throw ParseError(line, "no types listed");
+            }
+            for (size_t i = 1; i < tokens.size(); ++i)
+            {
+                if (local_type(names, tokens[i], line) != columns)
+                {
+                    throw ParseError(line, "type '" + std::string(tokens[i]) + "' listed twice");
+                }
+                ++columns;
+            }
+            has_types = true;
+            continue;
+        }
+
+        const size_t attacker = local_type(names, tokens.front(), line);
+        local_rows.resize(names.size(), 0);
+        seen.resize(names.size(), false);
+        if (seen[attacker])
+        {
+            throw ParseError(line, "duplicate row for '" + std::string(tokens.front()) + "'");
+        }
+        seen[attacker] = true;
+        if (tokens.size() != columns + 1)
+        {
+            throw ParseError(line, "expected " + std::to_string(columns) + " flags");
+        }
+        for (size_t i = 0; i < columns; ++i)
+        {
+            const std::string_view flag = tokens[i + 1];
+            if (flag != "0" && flag != "1")
+            {
+                throw ParseError(line, "expected 0 or 1");
+            }
+            local_rows[attacker] |= std::uint64_t(flag == "1") << i;
+        }
+    }
+
+    if (!has_types)
+    {
+        throw ParseError(line, "expected a 'types' line");
+    }
+
+    const size_t added = static_cast<size_t>(std::count_if(names.begin(), names.end(), [](std::string_view name)
+    {
+        return !TypeRegistry::contains(name);
+    }));
+    if (TypeRegistry::count() + added > MAX_NPC_TYPES)
+    {
+        throw ParseError(line, "too many types");
+    }
+
+    std::vector<NPCType> types;
+    try
+    {
+        for (std::string_view name : names)
+        {
+            types.push_back(TypeRegistry::add(name));
+        }
+    }
+    catch (const std::length_error&)
+    {
+        // Another thread registered types since the check above.
+        throw ParseError(line, "too many types");
+    }
+
+    RuleTable table;
+    for (size_t attacker = 0; attacker < local_rows.size(); ++attacker)
+    {
+        for (size_t column = 0; column < columns; ++column)
+        {
+            table.set(types[attacker], types[column], ((local_rows[attacker] >> column) & 1) != 0);
+        }
+    }
+    return table;
+}
+
+RuleTable RuleTable::load(const std::string& filename)
+{
+    const MappedFile mapping(filename);
+    return parse(mapping.view());
+}
+
+std::uint64_t RuleTable::victims_of(NPCType attacker) const
+{
+    const auto a = static_cast<std::size_t>(attacker);
+    return a < MAX_NPC_TYPES ? rows[a] : 0;
+}
+
+void RuleTable::set(NPCType attacker, NPCType defender, bool kills)
+{
+    const auto a = static_cast<std::size_t>(attacker);
+    const auto d = static_cast<std::size_t>(defender);
+    if (a >= MAX_NPC_TYPES || d >= MAX_NPC_TYPES)
+    {
+        throw std::invalid_argument("Unknown type");
+    }
+    if (kills)
+    {
+        rows[a] |= std::uint64_t(1) << d;
+    }
+    else
+    {
+        rows[a] &= ~(std::uint64_t(1) << d);
+    }
+}
\ No newline at end of file
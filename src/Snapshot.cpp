@@ -0,0 +1,189 @@
+#include "Snapshot.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+#include "TypeRegistry.h"
+
+namespace
+{
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t type_count;
+        std::uint64_t count;
+        std::uint64_t dictionary_offset;
+        std::uint64_t x_offset;
+        std::uint64_t y_offset;
+        std::uint64_t type_offset;
+        std::uint64_t alive_offset;
+        std::uint64_t file_size;
+    };
+
+    std::uint64_t align8(std::uint64_t offset)
+    {
+        return (offset + 7) & ~std::uint64_t(7);
+    }
+
+    void pad(std::ofstream& file, std::uint64_t from, std::uint64_t to)
+    {
+        static constexpr char zeros[8] = {};
+        file.write(zeros, static_cast<std::streamsize>(to - from));
+    }
+
+    void corrupted()
+    {
+        throw std::invalid_argument("Corrupted snapshot file");
+    }
+}
+
+void Snapshot::write(const NPCStore& store, const std::string& filename)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::invalid_argument("Unable to save data to file");
+    }
+
+    const size_t count = store.size();
+    std::vector<std::uint8_t> codes(count);
+    std::vector<int> code_of(256, -1);
+    std::vector<NPCType> dictionary;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto type = static_cast<std::uint8_t>(store.type(i));
+        if (code_of[type] < 0)
+        {
+            code_of[type] = static_cast<int>(dictionary.size());
+            dictionary.push_back(store.type(i));
+        }
+        codes[i] = static_cast<std::uint8_t>(code_of[type]);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.type_count = static_cast<std::uint32_t>(dictionary.size());
+    header.count = count;
+    header.dictionary_offset = sizeof(Header);
+
+    std::uint64_t offset = header.dictionary_offset;
+    for (NPCType type : dictionary)
+    {
+        offset += sizeof(std::uint16_t) + TypeRegistry::name(type).size();
+    }
+    header.x_offset = align8(offset);
+    header.y_offset = align8(header.x_offset + count * sizeof(int));
+    header.type_offset = align8(header.y_offset + count * sizeof(int));
+    header.alive_offset = align8(header.type_offset + count);
+    header.file_size = header.alive_offset + store.get_alive_bits().size() * sizeof(std::uint64_t);
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (NPCType type : dictionary)
+    {
+        const std::string_view name = TypeRegistry::name(type);
+        const auto length = static_cast<std::uint16_t>(name.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+    pad(file, offset, header.x_offset);
+    file.write(reinterpret_cast<const char*>(store.get_xs().data()), static_cast<std::streamsize>(count * sizeof(int)));
+    pad(file, header.x_offset + count * sizeof(int), header.y_offset);
+    file.write(reinterpret_cast<const char*>(store.get_ys().data()), static_cast<std::streamsize>(count * sizeof(int)));
+    pad(file, header.y_offset + count * sizeof(int), header.type_offset);
+    file.write(reinterpret_cast<const char*>(codes.data()), static_cast<std::streamsize>(count));
+    pad(file, header.type_offset + count, header.alive_offset);
+    file.write(reinterpret_cast<const char*>(store.get_alive_bits().data()),
+               static_cast<std::streamsize>(store.get_alive_bits().size() * sizeof(std::uint64_t)));
+
+    if (!file)
+    {
+        throw std::invalid_argument("Unable to save data to file");
+    }
+}
+
+void Snapshot::read(const std::string& filename, NPCStore& store)
+{
+    const MappedFile mapping(filename);
+    if (mapping.size() < sizeof(Header))
+    {
+        corrupted();
+    }
+
+    Header header{};
+    std::memcpy(&header, mapping.data(), sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        corrupted();
+    }
+    if (header.version != VERSION)
+    {
+        throw std::invalid_argument("Unsupported snapshot version");
+    }
+
+    // The offsets are ordered and within the file before any column size is
+    // compared against the gaps between them, so nothing can wrap around.
+    const std::uint64_t count = header.count;
+    const std::uint64_t words = (count + 63) / 64;
+    if (header.file_size != mapping.size() || count > mapping.size() ||
+        header.dictionary_offset < sizeof(Header) || header.x_offset < header.dictionary_offset ||
+        header.y_offset < header.x_offset || header.type_offset < header.y_offset ||
+        header.alive_offset < header.type_offset || header.alive_offset > mapping.size() ||
+        header.x_offset % 8 != 0 || header.y_offset % 8 != 0 || header.alive_offset % 8 != 0 ||
+        count * sizeof(int) > header.y_offset - header.x_offset ||
+        count * sizeof(int) > header.type_offset - header.y_offset ||
+        count > header.alive_offset - header.type_offset ||
+        words * sizeof(std::uint64_t) > mapping.size() - header.alive_offset)
+    {
+        corrupted();
+    }
+
+    std::vector<NPCType> dictionary;
+    std::uint64_t offset = header.dictionary_offset;
+    for (std::uint32_t i = 0; i < header.type_count; ++i)
+    {
+        std::uint16_t length = 0;
+        if (header.x_offset - offset < sizeof(length))
+        {
+            corrupted();
+        }
+        std::memcpy(&length, mapping.data() + offset, sizeof(length));
+        offset += sizeof(length);
+        if (header.x_offset - offset < length)
+        {
+            corrupted();
+        }
+        dictionary.push_back(TypeRegistry::add(std::string_view(mapping.data() + offset, length)));
+        offset += length;
+    }
+
+    const auto* codes = reinterpret_cast<const std::uint8_t*>(mapping.data() + header.type_offset);
+    std::vector<NPCType> types(count);
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        if (codes[i] >= dictionary.size())
+        {
+            corrupted();
+        }
+        types[i] = dictionary[codes[i]];
+    }
+
+    const auto* xs = reinterpret_cast<const int*>(mapping.data() + header.x_offset);
+    const auto* ys = reinterpret_cast<const int*>(mapping.data() + header.y_offset);
+    const auto* alive = reinterpret_cast<const std::uint64_t*>(mapping.data() + header.alive_offset);
+
+    store.clear();
+    store.append(std::span<const int>(xs, count), std::span<const int>(ys, count), types,
+                 std::span<const std::uint64_t>(alive, words));
+}
+
+bool Snapshot::is_snapshot(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(MAGIC)] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+#include <stdexcept>
+#include "DistanceKernel.h"
+
+namespace
+{
+    // Coordinates are 32-bit, so no query radius needs to reach further than this.
+    constexpr std::int64_t MAX_REACH = std::int64_t(1) << 33;
+
+    std::int64_t floor_div(std::int64_t value, std::int64_t divisor)
+    {
+        std::int64_t quotient = value / divisor;
+        if ((value % divisor != 0) && (value < 0))
+        {
+            --quotient;
+        }
+        return quotient;
+    }
+}
+
+SpatialGrid::SpatialGrid(const std::vector<int>& x, const std::vector<int>& y, std::int64_t cell_size) :
+                        cell_size(cell_size)
+{
+    if (cell_size <= 0)
+    {
+        throw std::invalid_argument("Cell size must be positive");
+    }
+    if (x.size() != y.size())
+    {
+        throw std::invalid_argument("Coordinate arrays differ in size");
+    }
+
+    const std::size_t n = x.size();
+    if (n == 0)
+    {
+        return;
+    }
+
+    std::vector<std::int64_t> cx(n);
+    std::vector<std::int64_t> cy(n);
+    min_cx = max_cx = cell_of(x[0]);
+    min_cy = max_cy = cell_of(y[0]);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        cx[i] = cell_of(x[i]);
+        cy[i] = cell_of(y[i]);
+        min_cx = std::min(min_cx, cx[i]);
+        max_cx = std::max(max_cx, cx[i]);
+        min_cy = std::min(min_cy, cy[i]);
+        max_cy = std::max(max_cy, cy[i]);
+    }
+
+    cols = max_cx - min_cx + 1;
+    rows = max_cy - min_cy + 1;
+    const std::int64_t dense_limit = std::max<std::int64_t>(4 * static_cast<std::int64_t>(n), 1024);
+    layout = (cols <= dense_limit && rows <= dense_limit / cols) ? Layout::Dense : Layout::Hashed;
+
+    ids.resize(n);
+    if (layout == Layout::Dense)
+    {
+        cell_start.assign(static_cast<std::size_t>(cols * rows) + 1, 0);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            ++cell_start[static_cast<std::size_t>((cy[i] - min_cy) * cols + (cx[i] - min_cx)) + 1];
+        }
+        std::partial_sum(cell_start.begin(), cell_start.end(), cell_start.begin());
+
+        std::vector<std::size_t> fill(cell_start.begin(), cell_start.end() - 1);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            ids[fill[static_cast<std::size_t>((cy[i] - min_cy) * cols + (cx[i] - min_cx))]++] = i;
+        }
+    }
+    else
+    {
+        std::vector<std::uint64_t> keys(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            keys[i] = key_of(cx[i], cy[i]);
+        }
+        std::iota(ids.begin(), ids.end(), 0);
+        std::stable_sort(ids.begin(), ids.end(), [&keys](std::size_t a, std::size_t b)
+        {
+            return keys[a] < keys[b];
+        });
+
+        cells.reserve(n);
+        std::size_t begin = 0;
+        while (begin < n)
+        {
+            std::size_t end = begin + 1;
+            while (end < n && keys[ids[end]] == keys[ids[begin]])
+            {
+                ++end;
+            }
+            cells.emplace(keys[ids[begin]], std::make_pair(begin, end));
+            begin = end;
+        }
+    }
+
+    xs.resize(n);
+    ys.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        xs[i] = x[ids[i]];
+        ys[i] = y[ids[i]];
+    }
+}
+
+std::size_t SpatialGrid::query(int x, int y, std::size_t radius, std::vector<std::size_t>& out) const
+{
+    std::size_t tests = 0;
+    if (ids.empty())
+    {
+        return tests;
+    }
+
+    const std::int64_t reach = static_cast<std::int64_t>(std::min<std::size_t>(radius, MAX_REACH));
+    const std::int64_t from_cx = std::max(floor_div(std::int64_t(x) - reach, cell_size), min_cx);
+    const std::int64_t to_cx = std::min(floor_div(std::int64_t(x) + reach, cell_size), max_cx);
+    const std::int64_t from_cy = std::max(floor_div(std::int64_t(y) - reach, cell_size), min_cy);
+    const std::int64_t to_cy = std::min(floor_div(std::int64_t(y) + reach, cell_size), max_cy);
+    if (from_cx > to_cx || from_cy > to_cy)
+    {
+        return tests;
+    }
+
+    if (layout == Layout::Dense)
+    {
+        for (std::int64_t cy = from_cy; cy <= to_cy; ++cy)
+        {
+            const std::size_t row = static_cast<std::size_t>((cy - min_cy) * cols);
+            const std::size_t first = row + static_cast<std::size_t>(from_cx - min_cx);
+            const std::size_t last = row + static_cast<std::size_t>(to_cx - min_cx);
+            tests += scan(cell_start[first], cell_start[last + 1], x, y, radius, out);
+        }
+        return tests;
+    }
+
+    const std::int64_t span_x = to_cx - from_cx + 1;
+    const std::int64_t span_y = to_cy - from_cy + 1;
+    if (span_x > static_cast<std::int64_t>(cells.size()) || span_y > static_cast<std::int64_t>(cells.size()) / span_x)
+    {
+        for (const auto& [key, range] : cells)
+        {
+            const std::int64_t cx = static_cast<std::int32_t>(key >> 32);
+            const std::int64_t cy = static_cast<std::int32_t>(key & 0xFFFFFFFFu);
+            if (cx >= from_cx && cx <= to_cx && cy >= from_cy && cy <= to_cy)
+            {
+                tests += scan(range.first, range.second, x, y, radius, out);
+            }
+        }
+        return tests;
+    }
+
+    for (std::int64_t cy = from_cy; cy <= to_cy; ++cy)
+    {
+        for (std::int64_t cx = from_cx; cx <= to_cx; ++cx)
+        {
+            const auto it = cells.find(key_of(cx, cy));
+            if (it != cells.end())
+            {
+                tests += scan(it->second.first, it->second.second, x, y, radius, out);
+            }
+        }
+    }
+    return tests;
+}
+
+SpatialGrid::Layout SpatialGrid::get_layout() const
+{
+    return layout;
+}
+
+std::size_t SpatialGrid::size() const
+{
+    return ids.size();
+}
+
+std::int64_t SpatialGrid::cell_of(int coordinate) const
+{
+    return floor_div(coordinate, cell_size);
+}
+
+std::size_t SpatialGrid::scan(std::size_t begin, std::size_t end, int x, int y, std::size_t radius,
+                       std::vector<std::size_t>& out) const
+{
+    for (std::size_t block = begin; block < end; block += DistanceKernel::BLOCK)
+    {
+        const std::size_t count = std::min(DistanceKernel::BLOCK, end - block);
+        std::uint64_t mask = DistanceKernel::in_range_mask(x, y, xs.data() + block, ys.data() + block, count, radius);
+        while (mask != 0)
+        {
+            out.push_back(ids[block + std::countr_zero(mask)]);
+            mask &= mask - 1;
+        }
+    }
+    return end - begin;
+}
+
+std::uint64_t SpatialGrid::key_of(std::int64_t cx, std::int64_t cy)
+{
+    return (std::uint64_t(static_cast<std::uint32_t>(cx)) << 32) | static_cast<std::uint32_t>(cy);
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include "DistanceKernel.h"
+#include "KdTree.h"
+#include "SpatialGrid.h"
+
+BruteForceIndex::BruteForceIndex(const std::vector<int>& x, const std::vector<int>& y) : xs(x), ys(y)
+{
+    if (x.size() != y.size())
+    {
+        throw std::invalid_argument("Coordinate arrays differ in size");
+    }
+}
+
+std::size_t BruteForceIndex::query(int x, int y, std::size_t radius, std::vector<std::size_t>& out) const
+{
+    for (std::size_t block = 0; block < xs.size(); block += DistanceKernel::BLOCK)
+    {
+        const std::size_t count = std::min(DistanceKernel::BLOCK, xs.size() - block);
+        std::uint64_t mask = DistanceKernel::in_range_mask(x, y, xs.data() + block, ys.data() + block, count, radius);
+        while (mask != 0)
+        {
+            out.push_back(block + std::countr_zero(mask));
+            mask &= mask - 1;
+        }
+    }
+    return xs.size();
+}
+
+std::size_t BruteForceIndex::size() const
+{
+    return xs.size();
+}
+
+std::unique_ptr<ISpatialIndex> SpatialIndex::build(SpatialIndexKind kind, const std::vector<int>& x,
+                                                   const std::vector<int>& y, std::size_t radius)
+{
+    switch (kind)
+    {
+        case SpatialIndexKind::BruteForce:
+            return std::make_unique<BruteForceIndex>(x, y);
+        case SpatialIndexKind::Grid:
+        {
+            constexpr std::size_t MAX_CELL = std::size_t(1) << 32;
+            return std::make_unique<SpatialGrid>(x, y, static_cast<std::int64_t>(std::clamp<std::size_t>(radius / 2, 1, MAX_CELL)));
+        }
+        case SpatialIndexKind::KdTree:
+            return std::make_unique<KdTree>(x, y);
+    }
+    throw std::invalid_argument("Unknown spatial index");
+}
\ No newline at end of file
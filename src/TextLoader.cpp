@@ -0,0 +1,125 @@
+#include "TextLoader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <vector>
+#include "MappedFile.h"
+#include "TypeRegistry.h"
+
+namespace
+{
+    bool is_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    const char* skip_spaces(const char* cursor, const char* end)
+    {
+        while (cursor != end && is_space(*cursor))
+        {
+            ++cursor;
+        }
+        return cursor;
+    }
+
+    const char* parse_int(const char* cursor, const char* end, int& value, size_t line)
+    {
+        cursor = skip_spaces(cursor, end);
+        // from_chars takes a '-' but not a '+', so a '+' is skipped here and
+        // must not be followed by another sign.
+        if (cursor != end && *cursor == '+')
+        {
+            ++cursor;
+            if (cursor != end && *cursor == '-')
+            {
+                throw ParseError(line, "expected an integer coordinate");
+            }
+        }
+        const auto [next, error] = std::from_chars(cursor, end, value);
+        if (error == std::errc::result_out_of_range)
+        {
+            throw ParseError(line, "coordinate out of range");
+        }
+        if (error != std::errc() || (next != end && !is_space(*next)))
+        {
+            throw ParseError(line, "expected an integer coordinate");
+        }
+        return next;
+    }
+
+    NPCType parse_type(std::string_view name, size_t line)
+    {
+        try
+        {
+            return TypeRegistry::find(name);
+        }
+        catch (const std::invalid_argument&)
+        {
+            throw ParseError(line, "unknown type '" + std::string(name) + "'");
+        }
+    }
+}
+
+ParseError::ParseError(size_t line, const std::string& reason) :
+                      std::invalid_argument("Malformed input at line " + std::to_string(line) + ": " + reason),
+                      line_number(line) {}
+
+size_t ParseError::line() const
+{
+    return line_number;
+}
+
+void TextLoader::read(const std::string& filename, NPCStore& store)
+{
+    const MappedFile mapping(filename);
+    parse(mapping.view(), store);
+}
+
+void TextLoader::parse(std::string_view text, NPCStore& store)
+{
+    const size_t lines = std::count(text.begin(), text.end(), '\n') + 1;
+    std::vector<int> xs;
+    std::vector<int> ys;
+    std::vector<NPCType> types;
+    xs.reserve(lines);
+    ys.reserve(lines);
+    types.reserve(lines);
+
+    const char* cursor = text.data();
+    const char* const end = text.data() + text.size();
+    size_t line = 0;
+    while (cursor != end)
+    {
+        ++line;
+        const char* line_end = std::find(cursor, end, '\n');
+
+        const char* token = skip_spaces(cursor, line_end);
+        if (token != line_end)
+        {
+            const char* token_end = token;
+            while (token_end != line_end && !is_space(*token_end))
+            {
+                ++token_end;
+            }
+
+            const NPCType type = parse_type(std::string_view(token, token_end - token), line);
+            int x = 0;
+            int y = 0;
+            const char* rest = parse_int(token_end, line_end, x, line);
+            rest = parse_int(rest, line_end, y, line);
+            if (skip_spaces(rest, line_end) != line_end)
+            {
+                throw ParseError(line, "unexpected trailing characters");
+            }
+
+            types.push_back(type);
+            xs.push_back(x);
+            ys.push_back(y);
+        }
+
+        cursor = line_end == end ? end : line_end + 1;
+    }
+
+    store.clear();
+    store.append(xs, ys, types);
+}
\ No newline at end of file
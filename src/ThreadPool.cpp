@@ -0,0 +1,122 @@
+#include "ThreadPool.h"
+
+#include <stdexcept>
+#include <utility>
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    if (threads == 0)
+    {
+        throw std::invalid_argument("Thread pool needs at least one thread");
+    }
+
+    workers.reserve(threads - 1);
+    for (size_t i = 1; i < threads; ++i)
+    {
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)>& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (workers.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        job_size = count;
+        next.store(0, std::memory_order_relaxed);
+        busy = workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+
+    work(task, count);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    job = nullptr;
+    if (failure)
+    {
+        std::rethrow_exception(std::exchange(failure, nullptr));
+    }
+}
+
+size_t ThreadPool::size() const
+{
+    return workers.size() + 1;
+}
+
+void ThreadPool::work(const std::function<void(size_t)>& task, size_t count)
+{
+    try
+    {
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = next.fetch_add(1, std::memory_order_relaxed))
+        {
+            task(i);
+        }
+    }
+    catch (...)
+    {
+        next.store(count, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failure)
+        {
+            failure = std::current_exception();
+        }
+    }
+}
+
+void ThreadPool::worker_loop()
+{
+    size_t seen = 0;
+    while (true)
+    {
+        const std::function<void(size_t)>* task;
+        size_t count;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping)
+            {
+                return;
+            }
+            seen = generation;
+            task = job;
+            count = job_size;
+        }
+
+        work(*task, count);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0)
+        {
+            done.notify_one();
+        }
+    }
+}
\ No newline at end of file
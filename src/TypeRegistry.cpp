@@ -0,0 +1,133 @@
+#include "TypeRegistry.h"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include "NPC.h"
+
+namespace
+{
+    struct NameHash
+    {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view name) const
+        {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    // Slots are written once before size is published, so name() reads them
+    // without locking; the hash map is guarded by the mutex.
+    class Registry final
+    {
+    public:
+        std::array<std::string, MAX_NPC_TYPES> names;
+        std::atomic<std::size_t> size = 0;
+        std::unordered_map<std::string, NPCType, NameHash, std::equal_to<>> ids;
+        std::shared_mutex mutex;
+    public:
+        Registry()
+        {
+            register_builtin(NPCTypeList{});
+        }
+    private:
+        template<typename... Ts>
+        void register_builtin(TypeList<Ts...>)
+        {
+            ((names[static_cast<std::size_t>(Ts::TYPE_ID)] = Ts::NAME), ...);
+            ((ids.emplace(Ts::NAME, Ts::TYPE_ID)), ...);
+            size.store(sizeof...(Ts), std::memory_order_release);
+        }
+    };
+
+    Registry& registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+}
+
+std::string_view TypeRegistry::name(NPCType type)
+{
+    const Registry& types = registry();
+    const auto index = static_cast<std::size_t>(type);
+    if (index >= types.size.load(std::memory_order_acquire))
+    {
+        throw std::invalid_argument("Unknown type");
+    }
+    return types.names[index];
+}
+
+NPCType TypeRegistry::find(std::string_view name)
+{
+    Registry& types = registry();
+    const std::shared_lock lock(types.mutex);
+    const auto it = types.ids.find(name);
+    if (it == types.ids.end())
+    {
+        throw std::invalid_argument("Unknown type");
+    }
+    return it->second;
+}
+
+NPCType TypeRegistry::add(std::string_view name)
+{
+    if (!is_valid_name(name))
+    {
+        throw std::invalid_argument("Invalid type name");
+    }
+
+    Registry& types = registry();
+    const std::unique_lock lock(types.mutex);
+    const auto it = types.ids.find(name);
+    if (it != types.ids.end())
+    {
+        return it->second;
+    }
+
+    const std::size_t index = types.size.load(std::memory_order_relaxed);
+    if (index >= MAX_NPC_TYPES)
+    {
+        throw std::length_error("Too many NPC types");
+    }
+    const auto type = static_cast<NPCType>(index);
+    types.names[index] = std::string(name);
+    types.ids.emplace(types.names[index], type);
+    types.size.store(index + 1, std::memory_order_release);
+    return type;
+}
+
+bool TypeRegistry::contains(std::string_view name)
+{
+    Registry& types = registry();
+    const std::shared_lock lock(types.mutex);
+    return types.ids.find(name) != types.ids.end();
+}
+
+std::size_t TypeRegistry::count()
+{
+    return registry().size.load(std::memory_order_acquire);
+}
+
+bool TypeRegistry::is_valid_name(std::string_view name)
+{
+    if (name.empty())
+    {
+        return false;
+    }
+    for (char c : name)
+    {
+        const bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        if (!letter && !(c >= '0' && c <= '9') && c != '_' && c != '-')
+        {
+            return false;
+        }
+    }
+    return true;
+}
\ No newline at end of file
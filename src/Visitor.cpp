@@ -2,40 +2,15 @@
 
 #include <utility>
 
-BattleVisitor::BattleVisitor(std::shared_ptr<NPC> attacker, std::vector<std::shared_ptr<IObserver>>& observers) :
-                            attacker(std::move(attacker)), observers(observers) {}
+BattleVisitor::BattleVisitor(std::shared_ptr<NPC> attacker, std::vector<std::shared_ptr<IObserver>>& observers,
+                             const RuleTable& rules) :
+                            attacker(std::move(attacker)), observers(observers), rules(rules) {}
 
-void BattleVisitor::try_to_kill(Dragon& defender)
-{
-    if (attacker->get_type() == "Frog" || attacker->get_type() == "Knight")
-    {
-        defender.is_alive = false;
-        notify(defender.get_type());
-    }
-}
-
-void BattleVisitor::try_to_kill(Frog& defender)
-{
-    if (attacker->get_type() == "Frog")
-    {
-        defender.is_alive = false;
-        notify(defender.get_type());
-    }
-}
-
-void BattleVisitor::try_to_kill(Knight& defender)
-{
-    if (attacker->get_type() == "Frog" || attacker->get_type() == "Dragon")
-    {
-        defender.is_alive = false;
-        notify(defender.get_type());
-    }
-}
-
-void BattleVisitor::notify(const std::string& victim_type) const
+void BattleVisitor::notify(NPCType victim_type) const
 {
+    const KillEvent event{attacker->get_type_id(), victim_type};
     for (const auto& observer : observers)
     {
-        observer->msg_kill(attacker->get_type(), victim_type);
+        observer->on_kill(event);
     }
 }
\ No newline at end of file
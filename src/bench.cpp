@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Arena.h"
+#include "EventPipeline.h"
+#include "PopulationGenerator.h"
+
+// Synthetic throughput benchmark. Usage:
+//   lab6_bench [--sizes 1000,10000] [--distributions uniform,clustered,line]
+//              [--distance 50] [--seed 42] [--index grid|kdtree|brute] [--threads N]
+//              [--report full|summary|sampled|final|off] [--dense-threshold 0.1]
+//              [--out results.json]
+// Results are written as one JSON document.
+
+namespace
+{
+    struct Options
+    {
+        std::vector<size_t> sizes = {1000, 10000, 100000, 1000000, 10000000};
+        std::vector<std::string> distributions = {"uniform", "clustered", "line"};
+        size_t distance = 50;
+        unsigned long long seed = 42;
+        SpatialIndexKind index = SpatialIndexKind::Grid;
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        SurvivorReport report = SurvivorReport::Full;
+        double dense_threshold = 0.1;
+        std::string out;
+    };
+
+    struct Result
+    {
+        std::string distribution;
+        size_t npcs = 0;
+        size_t survivors = 0;
+        double populate_ms = 0;
+        double battle_ms = 0;
+        double save_text_ms = 0;
+        double load_text_ms = 0;
+        double save_binary_ms = 0;
+        double load_binary_ms = 0;
+        double dispatch_sync_ms = 0;
+        double dispatch_async_ms = 0;
+    };
+
+    class CountingObserver final: public IObserver
+    {
+    public:
+        size_t kills = 0;
+    public:
+        void on_kill(const KillEvent&) override
+        {
+            ++kills;
+        }
+    };
+
+    std::vector<std::string> split(const std::string& list)
+    {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            if (!item.empty())
+            {
+                items.push_back(item);
+            }
+        }
+        return items;
+    }
+
+    Options parse_options(int argc, char** argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string flag = argv[i];
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("Missing value for " + flag);
+            }
+            const std::string value = argv[++i];
+            if (flag == "--sizes")
+            {
+                options.sizes.clear();
+                for (const auto& size : split(value))
+                {
+                    options.sizes.push_back(static_cast<size_t>(std::stod(size)));
+                }
+            }
+            else if (flag == "--distributions")
+            {
+                options.distributions = split(value);
+            }
+            else if (flag == "--distance")
+            {
+                options.distance = std::stoull(value);
+            }
+            else if (flag == "--seed")
+            {
+                options.seed = std::stoull(value);
+            }
+            else if (flag == "--index")
+            {
+                if (value == "grid")
+                {
+                    options.index = SpatialIndexKind::Grid;
+                }
+                else if (value == "kdtree")
+                {
+                    options.index = SpatialIndexKind::KdTree;
+                }
+                else if (value == "brute")
+                {
+                    options.index = SpatialIndexKind::BruteForce;
+                }
+                else
+                {
+                    throw std::invalid_argument("Unknown index " + value);
+                }
+            }
+            else if (flag == "--threads")
+            {
+                options.threads = std::max<size_t>(1, std::stoull(value));
+            }
+            else if (flag == "--report")
+            {
+                if (value == "full")
+                {
+                    options.report = SurvivorReport::Full;
+                }
+                else if (value == "summary")
+                {
+                    options.report = SurvivorReport::Summary;
+                }
+                else if (value == "sampled")
+                {
+                    options.report = SurvivorReport::Sampled;
+                }
+                else if (value == "final")
+                {
+                    options.report = SurvivorReport::FinalOnly;
+                }
+                else if (value == "off")
+                {
+                    options.report = SurvivorReport::Off;
+                }
+                else
+                {
+                    throw std::invalid_argument("Unknown report mode " + value);
+                }
+            }
+            else if (flag == "--dense-threshold")
+            {
+                options.dense_threshold = std::stod(value);
+            }
+            else if (flag == "--out")
+            {
+                options.out = value;
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown option " + flag);
+            }
+        }
+        return options;
+    }
+
+    double time_ms(const std::function<void()>& work)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        work();
+        const auto finish = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(finish - start).count();
+    }
+
+    Result run(const Options& options, const std::string& distribution, size_t count, std::ostream& sink)
+    {
+        const auto directory = std::filesystem::temp_directory_path();
+        const std::string text_path = (directory / "lab6_bench.txt").string();
+        const std::string binary_path = (directory / "lab6_bench.bin").string();
+
+        Result result;
+        result.distribution = distribution;
+        result.npcs = count;
+
+        // The population is generated on the arena's worker threads; it is the
+        // same for any thread count. Battles stay sequential.
+        Arena arena(ArenaConfig{"", "", false, &sink});
+        arena.set_spatial_index(options.index);
+        arena.set_thread_count(options.threads);
+        arena.set_survivor_report(options.report);
+        arena.set_dense_threshold(options.dense_threshold);
+        PopulationSpec spec;
+        spec.count = count;
+        spec.seed = options.seed;
+        spec.distribution = PopulationGenerator::parse_distribution(distribution);
+        result.populate_ms = time_ms([&] { arena.populate(spec); });
+
+        result.save_text_ms = time_ms([&] { arena.save_to_file(text_path); });
+        result.save_binary_ms = time_ms([&] { arena.save_to_file(binary_path, FileFormat::Binary); });
+        result.load_text_ms = time_ms([&] { arena.load_from_file(text_path); });
+        result.load_binary_ms = time_ms([&] { arena.load_from_file(binary_path); });
+        std::filesystem::remove(text_path);
+        std::filesystem::remove(binary_path);
+
+        result.battle_ms = time_ms([&] { arena.battle(options.distance); });
+        result.survivors = arena.get_npcs().alive_count();
+
+        // Observer dispatch is measured on a fixed stream of one event per NPC.
+        auto counter = std::make_shared<CountingObserver>();
+        std::vector<std::shared_ptr<IObserver>> observers = {counter};
+        const KillEvent event{NPCType::Frog, NPCType::Dragon};
+        result.dispatch_sync_ms = time_ms([&]
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                for (const auto& observer : observers)
+                {
+                    observer->on_kill(event);
+                }
+            }
+        });
+        EventPipeline pipeline(observers, 1 << 16, BackPressure::Block);
+        result.dispatch_async_ms = time_ms([&]
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                pipeline.push(event);
+            }
+            pipeline.flush();
+        });
+        return result;
+    }
+
+    void write_json(std::ostream& out, const Options& options, const std::vector<Result>& results)
+    {
+        out << "{\n  \"benchmark\": \"lab6\",\n  \"seed\": " << options.seed
+            << ",\n  \"distance\": " << options.distance << ",\n  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result& r = results[i];
+            out << (i == 0 ? "\n" : ",\n")
+                << "    {\"distribution\": \"" << r.distribution << "\", \"npcs\": " << r.npcs
+                << ", \"survivors\": " << r.survivors
+                << ", \"populate_ms\": " << r.populate_ms
+                << ", \"battle_ms\": " << r.battle_ms
+                << ", \"save_text_ms\": " << r.save_text_ms
+                << ", \"load_text_ms\": " << r.load_text_ms
+                << ", \"save_binary_ms\": " << r.save_binary_ms
+                << ", \"load_binary_ms\": " << r.load_binary_ms
+                << ", \"dispatch_sync_ms\": " << r.dispatch_sync_ms
+                << ", \"dispatch_async_ms\": " << r.dispatch_async_ms << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const Options options = parse_options(argc, argv);
+        std::ostream sink(nullptr);
+
+        std::vector<Result> results;
+        for (const auto& distribution : options.distributions)
+        {
+            for (size_t count : options.sizes)
+            {
+                std::cerr << "running " << distribution << ' ' << count << std::endl;
+                results.push_back(run(options, distribution, count, sink));
+            }
+        }
+
+        if (options.out.empty())
+        {
+            write_json(std::cout, options, results);
+        }
+        else
+        {
+            std::ofstream out(options.out);
+            if (!out.is_open())
+            {
+                throw std::invalid_argument("Unable to save data to file");
+            }
+            write_json(out, options, results);
+        }
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include "KillLog.h"
+#include "TypeRegistry.h"
+
+// Filters and aggregates a binary kill log. Usage:
+//   lab6_logq <log> [--rounds FIRST:LAST] [--region MIN_X,MIN_Y,MAX_X,MAX_Y]
+//             [--killer TYPE] [--victim TYPE] [--group type|round|region] [--cell SIZE]
+// Prints one "key count" line per group, followed by the total.
+
+namespace
+{
+    struct Query
+    {
+        std::string path;
+        KillLogFilter filter;
+        // Resolved once the log's dictionary has been registered.
+        std::string killer;
+        std::string victim;
+        std::string group = "type";
+        std::int64_t cell = 100;
+    };
+
+    std::int64_t floor_div(std::int64_t value, std::int64_t divisor)
+    {
+        std::int64_t quotient = value / divisor;
+        if ((value % divisor != 0) && (value < 0))
+        {
+            --quotient;
+        }
+        return quotient;
+    }
+
+    Query parse_query(int argc, char** argv)
+    {
+        if (argc < 2)
+        {
+            throw std::invalid_argument("Usage: lab6_logq <log> [--rounds A:B] [--region X0,Y0,X1,Y1] "
+                                        "[--killer TYPE] [--victim TYPE] [--group type|round|region] [--cell SIZE]");
+        }
+
+        Query query;
+        query.path = argv[1];
+        for (int i = 2; i < argc; ++i)
+        {
+            const std::string flag = argv[i];
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("Missing value for " + flag);
+            }
+            const std::string value = argv[++i];
+            if (flag == "--rounds")
+            {
+                const size_t colon = value.find(':');
+                query.filter.first_round = static_cast<std::uint32_t>(std::stoul(value.substr(0, colon)));
+                query.filter.last_round = colon == std::string::npos ? query.filter.first_round
+                                        : static_cast<std::uint32_t>(std::stoul(value.substr(colon + 1)));
+            }
+            else if (flag == "--region")
+            {
+                char separator = 0;
+                std::istringstream stream(value);
+                stream >> query.filter.min_x >> separator >> query.filter.min_y >> separator
+                       >> query.filter.max_x >> separator >> query.filter.max_y;
+                if (!stream)
+                {
+                    throw std::invalid_argument("Malformed region " + value);
+                }
+            }
+            else if (flag == "--killer")
+            {
+                query.killer = value;
+            }
+            else if (flag == "--victim")
+            {
+                query.victim = value;
+            }
+            else if (flag == "--group")
+            {
+                if (value != "type" && value != "round" && value != "region")
+                {
+                    throw std::invalid_argument("Unknown grouping " + value);
+                }
+                query.group = value;
+            }
+            else if (flag == "--cell")
+            {
+                query.cell = std::stoll(value);
+                if (query.cell <= 0)
+                {
+                    throw std::invalid_argument("Cell size must be positive");
+                }
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown option " + flag);
+            }
+        }
+        return query;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        Query query = parse_query(argc, argv);
+        const KillLogReader reader(query.path);
+        if (!query.killer.empty())
+        {
+            query.filter.killers = type_mask(TypeRegistry::find(query.killer));
+        }
+        if (!query.victim.empty())
+        {
+            query.filter.victims = type_mask(TypeRegistry::find(query.victim));
+        }
+
+        std::map<std::tuple<std::int64_t, std::int64_t>, std::uint64_t> groups;
+        std::uint64_t total = 0;
+        reader.scan(query.filter, [&query, &groups, &total](const KillEvent& event)
+        {
+            ++total;
+            if (query.group == "type")
+            {
+                ++groups[{static_cast<std::int64_t>(event.killer), static_cast<std::int64_t>(event.victim)}];
+            }
+            else if (query.group == "round")
+            {
+                ++groups[{event.round, 0}];
+            }
+            else
+            {
+                ++groups[{floor_div(event.victim_x, query.cell), floor_div(event.victim_y, query.cell)}];
+            }
+        });
+
+        for (const auto& [key, count] : groups)
+        {
+            const auto [first, second] = key;
+            if (query.group == "type")
+            {
+                std::cout << TypeRegistry::name(static_cast<NPCType>(first)) << " killed "
+                          << TypeRegistry::name(static_cast<NPCType>(second)) << ' ' << count << '\n';
+            }
+            else if (query.group == "round")
+            {
+                std::cout << "round " << first << ' ' << count << '\n';
+            }
+            else
+            {
+                std::cout << "cell " << first * query.cell << ',' << second * query.cell << ' ' << count << '\n';
+            }
+        }
+        std::cout << "total " << total << std::endl;
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+}
\ No newline at end of file
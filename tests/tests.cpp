@@ -3,12 +3,45 @@
 #include <sstream>
 #include <fstream>
 #include <cstdio>
+#include <cstring>
 #include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <tuple>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <random>
+#include <set>
+#include <climits>
 #include "Arena.h"
 #include "NPC.h"
 #include "Factory.h"
 #include "Visitor.h"
 #include "Observer.h"
+#include "SpatialGrid.h"
+#include "PairQueue.h"
+#include "RadiusSchedule.h"
+#include "NPCStore.h"
+#include "DistanceKernel.h"
+#include "KillTable.h"
+#include "TypeRegistry.h"
+#include "ThreadPool.h"
+#include "EventPipeline.h"
+#include "RingBuffer.h"
+#include "Snapshot.h"
+#include "TextLoader.h"
+#include "NPCPool.h"
+#include "BattleStats.h"
+#include "KillLog.h"
+#include "KdTree.h"
+#include "SpatialIndex.h"
+#include "NPCTypeList.h"
+#include "RuleTable.h"
+#include "PopulationGenerator.h"
+#include "DenseKernel.h"
+#include "MappedLog.h"
+#include "AggregatingObserver.h"
 
 namespace fs = std::filesystem;
 
@@ -766,6 +799,2040 @@ TEST_F(EdgeCasesTest, DistanceCalculationWithNegatives) {
     EXPECT_TRUE(dragon1.is_close(dragon2, 300));
 }
 
+// ============== Spatial Grid Tests ==============
+
+namespace {
+
+std::vector<size_t> brute_force_query(const std::vector<int>& xs, const std::vector<int>& ys,
+                                      int x, int y, size_t radius) {
+    std::vector<size_t> result;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        if (NPC::is_close(x, y, xs[i], ys[i], radius)) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+// Runs the original all-pairs battle over standalone NPC objects and returns
+// the survivors in save_to_file format.
+std::string reference_battle(const std::vector<std::tuple<std::string, int, int>>& population,
+                             size_t distance, size_t step = 10) {
+    std::vector<std::shared_ptr<NPC>> npcs;
+    for (const auto& [type, x, y] : population) {
+        npcs.push_back(INPCFactory::create_npc(type, x, y));
+    }
+    std::vector<std::shared_ptr<IObserver>> no_observers;
+    for (size_t range = 0; range <= distance; range += step) {
+        for (auto& attacker : npcs) {
+            for (auto& defender : npcs) {
+                if (attacker != defender && attacker->is_alive && defender->is_alive &&
+                    attacker->is_close(*defender, range)) {
+                    BattleVisitor visitor(attacker, no_observers);
+                    defender->accept(visitor);
+                }
+            }
+        }
+    }
+    std::ostringstream out;
+    for (const auto& npc : npcs) {
+        if (npc->is_alive) {
+            out << npc->get_type() << ' ' << npc->x << ' ' << npc->y << '\n';
+        }
+    }
+    return out.str();
+}
+
+std::vector<std::tuple<std::string, int, int>> random_population(size_t count, int extent, unsigned seed) {
+    static const char* types[] = {"Dragon", "Frog", "Knight"};
+    std::vector<std::tuple<std::string, int, int>> population;
+    unsigned state = seed;
+    auto next = [&state]() {
+        state = state * 1103515245u + 12345u;
+        return (state >> 8) & 0xFFFFFF;
+    };
+    for (size_t i = 0; i < count; ++i) {
+        const int x = static_cast<int>(next() % (2 * extent + 1)) - extent;
+        const int y = static_cast<int>(next() % (2 * extent + 1)) - extent;
+        population.emplace_back(types[next() % 3], x, y);
+    }
+    return population;
+}
+
+std::string arena_battle(const std::vector<std::tuple<std::string, int, int>>& population,
+                         size_t distance) {
+    Arena& arena = Arena::get_instance();
+    arena.clear_npcs();
+    for (const auto& [type, x, y] : population) {
+        arena.add_npc(type, x, y);
+    }
+
+    std::stringstream buffer;
+    std::streambuf* old = std::cout.rdbuf(buffer.rdbuf());
+    arena.battle(distance);
+    std::cout.rdbuf(old);
+
+    arena.save_to_file("grid_result.txt");
+    std::ifstream result("grid_result.txt");
+    std::stringstream content;
+    content << result.rdbuf();
+    result.close();
+    std::remove("grid_result.txt");
+    return content.str();
+}
+
+}
+
+class SpatialGridTest : public ::testing::Test {};
+
+TEST_F(SpatialGridTest, EmptyGrid) {
+    SpatialGrid grid({}, {}, 10);
+    std::vector<size_t> out;
+    grid.query(0, 0, 100, out);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST_F(SpatialGridTest, InvalidCellSize) {
+    EXPECT_THROW(SpatialGrid({0}, {0}, 0), std::invalid_argument);
+}
+
+TEST_F(SpatialGridTest, DenseMatchesBruteForce) {
+    std::vector<int> xs, ys;
+    for (const auto& [type, x, y] : random_population(500, 200, 7)) {
+        xs.push_back(x);
+        ys.push_back(y);
+    }
+    SpatialGrid grid(xs, ys, 10);
+    EXPECT_EQ(grid.get_layout(), SpatialGrid::Layout::Dense);
+
+    for (size_t radius : {0u, 5u, 10u, 37u, 150u, 1000u}) {
+        for (size_t i = 0; i < xs.size(); i += 13) {
+            std::vector<size_t> out;
+            grid.query(xs[i], ys[i], radius, out);
+            std::sort(out.begin(), out.end());
+            EXPECT_EQ(out, brute_force_query(xs, ys, xs[i], ys[i], radius));
+        }
+    }
+}
+
+TEST_F(SpatialGridTest, HashedMatchesBruteForce) {
+    std::vector<int> xs = {-2000000000, 2000000000, 0, 5, -7, 1999999990, -1999999995};
+    std::vector<int> ys = {2000000000, -2000000000, 0, 3, -9, -1999999999, 2000000000};
+    SpatialGrid grid(xs, ys, 10);
+    EXPECT_EQ(grid.get_layout(), SpatialGrid::Layout::Hashed);
+
+    for (size_t radius : {0u, 10u, 20u, 100u}) {
+        for (size_t i = 0; i < xs.size(); ++i) {
+            std::vector<size_t> out;
+            grid.query(xs[i], ys[i], radius, out);
+            std::sort(out.begin(), out.end());
+            EXPECT_EQ(out, brute_force_query(xs, ys, xs[i], ys[i], radius));
+        }
+    }
+}
+
+TEST_F(SpatialGridTest, BattleMatchesFullScan) {
+    for (unsigned seed : {1u, 2u, 3u}) {
+        const auto population = random_population(300, 150, seed);
+        EXPECT_EQ(arena_battle(population, 100), reference_battle(population, 100));
+    }
+}
+
+// ============== Pair Queue Tests ==============
+
+class PairQueueTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        Arena::get_instance().set_radius_step(10);
+    }
+};
+
+TEST_F(PairQueueTest, LinearScheduleMatchesOldLoop) {
+    EXPECT_EQ(RadiusSchedule::linear(25, 10).get_radii(), (std::vector<size_t>{0, 10, 20}));
+    EXPECT_EQ(RadiusSchedule::linear(20, 10).get_radii(), (std::vector<size_t>{0, 10, 20}));
+    EXPECT_EQ(RadiusSchedule::linear(0, 10).get_radii(), (std::vector<size_t>{0}));
+}
+
+TEST_F(PairQueueTest, InvalidSchedules) {
+    EXPECT_THROW(RadiusSchedule::linear(10, 0), std::invalid_argument);
+    EXPECT_THROW(RadiusSchedule({10, 5}), std::invalid_argument);
+    EXPECT_THROW(Arena::get_instance().set_radius_step(0), std::invalid_argument);
+}
+
+TEST_F(PairQueueTest, PairsLandInFirstReachingBand) {
+    std::vector<int> xs = {0, 3, 0, 100};
+    std::vector<int> ys = {0, 4, 12, 0};
+    PairQueue queue(xs, ys, RadiusSchedule({0, 5, 10, 15}));
+
+    ASSERT_EQ(queue.rounds(), 4u);
+    EXPECT_TRUE(queue.band(0).empty());
+    ASSERT_EQ(queue.band(1).size(), 2u);
+    EXPECT_EQ(queue.band(1)[0].attacker, 0u);
+    EXPECT_EQ(queue.band(1)[0].defender, 1u);
+    EXPECT_EQ(queue.band(1)[1].attacker, 1u);
+    EXPECT_EQ(queue.band(1)[1].defender, 0u);
+    EXPECT_EQ(queue.band(2).size(), 2u);
+    EXPECT_EQ(queue.band(3).size(), 2u);
+    EXPECT_EQ(queue.size(), 6u);
+}
+
+TEST_F(PairQueueTest, CustomStepMatchesFullScan) {
+    const auto population = random_population(300, 120, 11);
+    Arena::get_instance().set_radius_step(7);
+    EXPECT_EQ(arena_battle(population, 90), reference_battle(population, 90, 7));
+}
+
+// ============== NPC Store Tests ==============
+
+class NPCStoreTest : public ::testing::Test {};
+
+TEST_F(NPCStoreTest, AddStoresColumns) {
+    NPCStore store;
+    store.add(NPCType::Dragon, 1, 2);
+    store.add(NPCType::Knight, -3, 4);
+
+    EXPECT_EQ(store.size(), 2u);
+    EXPECT_EQ(store.get_xs(), (std::vector<int>{1, -3}));
+    EXPECT_EQ(store.get_ys(), (std::vector<int>{2, 4}));
+    EXPECT_EQ(store.type(1), NPCType::Knight);
+    EXPECT_TRUE(store.is_alive(0));
+    EXPECT_EQ(store.alive_count(), 2u);
+}
+
+TEST_F(NPCStoreTest, KillClearsAliveBit) {
+    NPCStore store;
+    for (int i = 0; i < 130; ++i) {
+        store.add(NPCType::Frog, i, i);
+    }
+    store.kill(64);
+    store.kill(64);
+    store.kill(129);
+
+    EXPECT_FALSE(store.is_alive(64));
+    EXPECT_FALSE(store.is_alive(129));
+    EXPECT_TRUE(store.is_alive(63));
+    EXPECT_TRUE(store.is_alive(65));
+    EXPECT_EQ(store.alive_count(), 128u);
+}
+
+TEST_F(NPCStoreTest, HandlesResolveToRecords) {
+    NPCStore store;
+    store.add(NPCType::Dragon, 0, 0);
+    NPCHandle handle = store.add(NPCType::Frog, 7, 8);
+
+    EXPECT_EQ(store.index_of(handle), 1u);
+    EXPECT_EQ(store.handle(1), handle);
+}
+
+TEST_F(NPCStoreTest, ViewReflectsRecord) {
+    NPCStore store;
+    store.add(NPCType::Knight, 30, 40);
+    store.kill(0);
+
+    auto npc = store.view(0);
+    EXPECT_EQ(npc->get_type(), "Knight");
+    EXPECT_EQ(npc->x, 30);
+    EXPECT_EQ(npc->y, 40);
+    EXPECT_FALSE(npc->is_alive);
+}
+
+TEST_F(NPCStoreTest, FactoryAddsToStore) {
+    NPCStore store;
+    NPCHandle handle = INPCFactory::create_npc(store, "Dragon", 5, 6);
+    EXPECT_EQ(store.type(store.index_of(handle)), NPCType::Dragon);
+    EXPECT_THROW(INPCFactory::create_npc(store, "Unicorn", 0, 0), std::invalid_argument);
+    EXPECT_EQ(store.size(), 1u);
+}
+
+TEST_F(NPCStoreTest, ArenaReturnsViews) {
+    Arena& arena = Arena::get_instance();
+    arena.clear_npcs();
+    NPCHandle handle = arena.add_npc("Frog", 3, 4);
+    auto npc = arena.get_npc(handle);
+    EXPECT_EQ(npc->get_type(), "Frog");
+    EXPECT_EQ(npc->x, 3);
+    EXPECT_EQ(arena.get_npcs().size(), 1u);
+    arena.clear_npcs();
+}
+
+// ============== Distance Kernel Tests ==============
+
+class DistanceKernelTest : public ::testing::Test {
+protected:
+    DistanceKernel::Isa original = DistanceKernel::get_isa();
+
+    void TearDown() override {
+        DistanceKernel::set_isa(original);
+    }
+
+    static std::vector<DistanceKernel::Isa> supported() {
+        std::vector<DistanceKernel::Isa> result;
+        for (auto isa : {DistanceKernel::Isa::Scalar, DistanceKernel::Isa::SSE, DistanceKernel::Isa::AVX2}) {
+            if (DistanceKernel::is_supported(isa)) {
+                result.push_back(isa);
+            }
+        }
+        return result;
+    }
+};
+
+TEST_F(DistanceKernelTest, ScalarAlwaysSupported) {
+    EXPECT_TRUE(DistanceKernel::is_supported(DistanceKernel::Isa::Scalar));
+}
+
+TEST_F(DistanceKernelTest, MatchesIsCloseForEveryIsa) {
+    std::vector<int> xs, ys;
+    for (const auto& [type, x, y] : random_population(64, 50, 5)) {
+        xs.push_back(x);
+        ys.push_back(y);
+    }
+    for (auto isa : supported()) {
+        DistanceKernel::set_isa(isa);
+        for (size_t count : {0u, 1u, 3u, 7u, 64u}) {
+            for (size_t radius : {0u, 10u, 35u, 200u}) {
+                uint64_t mask = DistanceKernel::in_range_mask(xs[0], ys[0], xs.data(), ys.data(), count, radius);
+                for (size_t k = 0; k < 64; ++k) {
+                    bool expected = k < count && NPC::is_close(xs[0], ys[0], xs[k], ys[k], radius);
+                    EXPECT_EQ(((mask >> k) & 1) != 0, expected);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(DistanceKernelTest, ExtremeCoordinatesDoNotOverflow) {
+    std::vector<int> xs = {2147483647, -2147483647 - 1, 2147483647, 0, 65536, -65536, 46341, 0};
+    std::vector<int> ys = {2147483647, -2147483647 - 1, -2147483647 - 1, 0, 0, 0, 46341, 65537};
+    for (auto isa : supported()) {
+        DistanceKernel::set_isa(isa);
+        // The two far corners are ~6e9 apart: never in range of a 32-bit radius.
+        EXPECT_EQ(DistanceKernel::in_range_mask(-2147483647 - 1, -2147483647 - 1, xs.data(), ys.data(), 1, 4294967295u), 0u);
+        EXPECT_EQ(DistanceKernel::in_range_mask(0, 0, xs.data(), ys.data(), 8, 65536) & 0xFF, 0x38u);
+        EXPECT_EQ(DistanceKernel::in_range_mask(0, 0, xs.data(), ys.data(), 8, 65537) & 0xFF, 0xF8u);
+    }
+    EXPECT_FALSE(NPC::is_close(-2147483647 - 1, -2147483647 - 1, 2147483647, 2147483647, 4294967295u));
+    EXPECT_TRUE(NPC::is_close(-2147483647 - 1, -2147483647 - 1, 2147483647, 2147483647, ~size_t(0)));
+}
+
+TEST_F(DistanceKernelTest, BlockLimit) {
+    std::vector<int> xs(65, 0), ys(65, 0);
+    EXPECT_THROW(DistanceKernel::in_range_mask(0, 0, xs.data(), ys.data(), 65, 1), std::invalid_argument);
+}
+
+// ============== Kill Table Tests ==============
+
+static_assert(KillTable::can_kill(NPCType::Frog, NPCType::Dragon));
+static_assert(!KillTable::can_kill(NPCType::Dragon, NPCType::Dragon));
+
+class KillTableTest : public ::testing::Test {};
+
+TEST_F(KillTableTest, MatchesVisitorRules) {
+    const std::vector<std::string> names = {"Dragon", "Frog", "Knight"};
+    std::vector<std::shared_ptr<IObserver>> no_observers;
+    for (const auto& attacker_name : names) {
+        for (const auto& defender_name : names) {
+            auto attacker = INPCFactory::create_npc(attacker_name, 0, 0);
+            auto defender = INPCFactory::create_npc(defender_name, 0, 0);
+            BattleVisitor visitor(attacker, no_observers);
+            defender->accept(visitor);
+            EXPECT_EQ(!defender->is_alive,
+                      KillTable::can_kill(attacker->get_type_id(), defender->get_type_id()))
+                << attacker_name << " vs " << defender_name;
+        }
+    }
+}
+
+TEST_F(KillTableTest, TypeIds) {
+    EXPECT_EQ(Dragon(0, 0).get_type_id(), NPCType::Dragon);
+    EXPECT_EQ(Frog(0, 0).get_type_id(), NPCType::Frog);
+    EXPECT_EQ(Knight(0, 0).get_type_id(), NPCType::Knight);
+    EXPECT_EQ(KillTable::victims_of(NPCType::Frog), 0x7u);
+}
+
+// ============== Type Registry Tests ==============
+
+class TypeRegistryTest : public ::testing::Test {};
+
+class TypedObserver : public IObserver {
+public:
+    std::vector<KillEvent> events;
+
+    void on_kill(const KillEvent& event) override {
+        events.push_back(event);
+    }
+};
+
+TEST_F(TypeRegistryTest, NamesRoundTrip) {
+    for (NPCType type : {NPCType::Dragon, NPCType::Frog, NPCType::Knight}) {
+        EXPECT_EQ(TypeRegistry::find(TypeRegistry::name(type)), type);
+    }
+    EXPECT_THROW(TypeRegistry::find("Unicorn"), std::invalid_argument);
+}
+
+TEST_F(TypeRegistryTest, NamesAreInterned) {
+    Dragon first(0, 0);
+    Dragon second(1, 1);
+    EXPECT_EQ(first.get_type().data(), second.get_type().data());
+    EXPECT_EQ(first.get_type().data(), TypeRegistry::name(NPCType::Dragon).data());
+}
+
+TEST_F(TypeRegistryTest, ObserversReceiveTypeIds) {
+    auto frog = INPCFactory::create_npc("Frog", 0, 0);
+    auto knight = INPCFactory::create_npc("Knight", 0, 0);
+    auto typed = std::make_shared<TypedObserver>();
+    auto legacy = std::make_shared<MockObserver>();
+    std::vector<std::shared_ptr<IObserver>> obs = {typed, legacy};
+
+    BattleVisitor visitor(frog, obs);
+    knight->accept(visitor);
+
+    ASSERT_EQ(typed->events.size(), 1u);
+    EXPECT_EQ(typed->events[0].killer, NPCType::Frog);
+    EXPECT_EQ(typed->events[0].victim, NPCType::Knight);
+    EXPECT_EQ(legacy->last_killer, "Frog");
+    EXPECT_EQ(legacy->last_victim, "Knight");
+}
+
+// ============== Simultaneous Resolution Tests ==============
+
+class SimultaneousBattleTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        Arena& arena = Arena::get_instance();
+        arena.set_resolution_mode(ResolutionMode::Sequential);
+        arena.set_thread_count(1);
+    }
+};
+
+TEST_F(SimultaneousBattleTest, ThreadPoolRunsEveryTask) {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(1000);
+    pool.run(hits.size(), [&hits](size_t i) { hits[i]++; });
+    pool.run(hits.size(), [&hits](size_t i) { hits[i]++; });
+    for (const auto& hit : hits) {
+        EXPECT_EQ(hit.load(), 2);
+    }
+    EXPECT_EQ(pool.size(), 4u);
+    EXPECT_THROW(ThreadPool(0), std::invalid_argument);
+}
+
+TEST_F(SimultaneousBattleTest, ThreadPoolRethrowsTaskExceptions) {
+    ThreadPool pool(4);
+    for (int attempt = 0; attempt < 20; ++attempt) {
+        EXPECT_THROW(pool.run(1000, [](size_t i) {
+            if (i % 7 == 3) {
+                throw std::runtime_error("task failed");
+            }
+        }), std::runtime_error);
+        EXPECT_THROW(pool.run(1000, [](size_t) { throw std::invalid_argument("every task"); }),
+                     std::invalid_argument);
+    }
+
+    std::atomic<size_t> ran{0};
+    pool.run(100, [&ran](size_t) { ran++; });
+    EXPECT_EQ(ran.load(), 100u);
+}
+
+TEST_F(SimultaneousBattleTest, MutualKillsResolveTogether) {
+    const std::vector<std::tuple<std::string, int, int>> frogs = {{"Frog", 0, 0}, {"Frog", 1, 1}};
+    EXPECT_EQ(arena_battle(frogs, 10), "Frog 0 0\n");
+
+    Arena::get_instance().set_resolution_mode(ResolutionMode::Simultaneous);
+    EXPECT_EQ(arena_battle(frogs, 10), "");
+}
+
+TEST_F(SimultaneousBattleTest, IdenticalForAnyThreadCount) {
+    const auto population = random_population(3000, 400, 21);
+    Arena& arena = Arena::get_instance();
+    arena.set_resolution_mode(ResolutionMode::Simultaneous);
+
+    arena.set_thread_count(1);
+    const std::string expected = arena_battle(population, 60);
+    for (size_t threads : {2u, 3u, 8u}) {
+        arena.set_thread_count(threads);
+        EXPECT_EQ(arena_battle(population, 60), expected);
+    }
+}
+
+TEST_F(SimultaneousBattleTest, SequentialRemainsReference) {
+    const auto population = random_population(300, 150, 4);
+    Arena::get_instance().set_thread_count(4);
+    EXPECT_EQ(arena_battle(population, 100), reference_battle(population, 100));
+}
+
+// ============== Event Pipeline Tests ==============
+
+namespace {
+
+class CountingObserver : public IObserver {
+public:
+    std::atomic<size_t> kills{0};
+    std::atomic<size_t> flushes{0};
+    std::mutex gate;
+
+    void on_kill(const KillEvent&) override {
+        std::lock_guard<std::mutex> lock(gate);
+        kills++;
+    }
+
+    void flush() override {
+        flushes++;
+    }
+};
+
+}
+
+class EventPipelineTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        Arena::get_instance().set_async_observers(false);
+    }
+};
+
+TEST_F(EventPipelineTest, RingBufferIsFifoAndBounded) {
+    RingBuffer<int> ring(4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(ring.try_push(i));
+    }
+    EXPECT_FALSE(ring.try_push(4));
+
+    int value = -1;
+    EXPECT_TRUE(ring.try_pop(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(ring.try_push(4));
+    for (int expected = 1; expected <= 4; ++expected) {
+        EXPECT_TRUE(ring.try_pop(value));
+        EXPECT_EQ(value, expected);
+    }
+    EXPECT_FALSE(ring.try_pop(value));
+    EXPECT_THROW(RingBuffer<int>(3), std::invalid_argument);
+}
+
+TEST_F(EventPipelineTest, SingleEventsArriveWithoutBarrier) {
+    auto observer = std::make_shared<CountingObserver>();
+    EventPipeline pipeline({observer}, 8, BackPressure::Block);
+    for (size_t i = 1; i <= 20000; ++i) {
+        pipeline.push({NPCType::Frog, NPCType::Dragon});
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (pipeline.delivered_count() < i && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(pipeline.delivered_count(), i);
+    }
+    EXPECT_EQ(observer->kills.load(), 20000u);
+}
+
+TEST_F(EventPipelineTest, BlockDeliversEverything) {
+    auto observer = std::make_shared<CountingObserver>();
+    EventPipeline pipeline({observer}, 8, BackPressure::Block);
+    for (int i = 0; i < 10000; ++i) {
+        pipeline.push({NPCType::Frog, NPCType::Dragon});
+    }
+    pipeline.flush();
+    EXPECT_EQ(observer->kills.load(), 10000u);
+    EXPECT_EQ(pipeline.delivered_count(), 10000u);
+    EXPECT_EQ(pipeline.dropped_count(), 0u);
+    EXPECT_GE(observer->flushes.load(), 1u);
+}
+
+TEST_F(EventPipelineTest, CountDropsWhenFull) {
+    auto observer = std::make_shared<CountingObserver>();
+    EventPipeline pipeline({observer}, 4, BackPressure::CountDrops);
+    {
+        std::unique_lock<std::mutex> hold(observer->gate);
+        for (int i = 0; i < 100; ++i) {
+            pipeline.push({NPCType::Frog, NPCType::Frog});
+        }
+    }
+    pipeline.flush();
+    EXPECT_EQ(pipeline.delivered_count() + pipeline.dropped_count(), 100u);
+    EXPECT_GT(pipeline.dropped_count(), 0u);
+    EXPECT_EQ(observer->kills.load(), pipeline.delivered_count());
+}
+
+TEST_F(EventPipelineTest, DropOldestKeepsNewest) {
+    auto observer = std::make_shared<TypedObserver>();
+    auto blocker = std::make_shared<CountingObserver>();
+    EventPipeline pipeline({blocker, observer}, 4, BackPressure::DropOldest);
+    {
+        std::unique_lock<std::mutex> hold(blocker->gate);
+        for (int i = 0; i < 50; ++i) {
+            pipeline.push({NPCType::Frog, NPCType::Frog});
+        }
+        pipeline.push({NPCType::Knight, NPCType::Dragon});
+    }
+    pipeline.flush();
+    EXPECT_EQ(pipeline.delivered_count() + pipeline.dropped_count(), 51u);
+    EXPECT_GT(pipeline.dropped_count(), 0u);
+    ASSERT_FALSE(observer->events.empty());
+    EXPECT_EQ(observer->events.back().killer, NPCType::Knight);
+}
+
+TEST_F(EventPipelineTest, AsyncBattleMatchesSync) {
+    const auto population = random_population(400, 150, 9);
+    const std::string expected = arena_battle(population, 100);
+    Arena::get_instance().set_async_observers(true, 16, BackPressure::Block);
+    EXPECT_EQ(arena_battle(population, 100), expected);
+}
+
+// ============== Snapshot Tests ==============
+
+class SnapshotTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        std::remove("snapshot.bin");
+        std::remove("snapshot.txt");
+        Arena::get_instance().clear_npcs();
+    }
+};
+
+TEST_F(SnapshotTest, RoundTripKeepsColumns) {
+    NPCStore store;
+    for (int i = 0; i < 200; ++i) {
+        store.add(static_cast<NPCType>(i % 3), i * 7 - 500, -i);
+    }
+    store.kill(3);
+    store.kill(150);
+
+    Snapshot::write(store, "snapshot.bin");
+    EXPECT_TRUE(Snapshot::is_snapshot("snapshot.bin"));
+
+    NPCStore loaded;
+    loaded.add(NPCType::Frog, 1, 1);
+    Snapshot::read("snapshot.bin", loaded);
+    EXPECT_EQ(loaded.get_xs(), store.get_xs());
+    EXPECT_EQ(loaded.get_ys(), store.get_ys());
+    EXPECT_EQ(loaded.get_types(), store.get_types());
+    EXPECT_EQ(loaded.get_alive_bits(), store.get_alive_bits());
+    EXPECT_EQ(loaded.alive_count(), 198u);
+}
+
+TEST_F(SnapshotTest, EmptySnapshot) {
+    NPCStore store;
+    Snapshot::write(store, "snapshot.bin");
+    NPCStore loaded;
+    Snapshot::read("snapshot.bin", loaded);
+    EXPECT_EQ(loaded.size(), 0u);
+}
+
+TEST_F(SnapshotTest, ArenaLoadsEitherFormat) {
+    Arena& arena = Arena::get_instance();
+    arena.clear_npcs();
+    arena.add_npc("Dragon", 10, 20);
+    arena.add_npc("Knight", -3, 4);
+    arena.save_to_file("snapshot.bin", FileFormat::Binary);
+    arena.save_to_file("snapshot.txt");
+    EXPECT_FALSE(Snapshot::is_snapshot("snapshot.txt"));
+
+    arena.load_from_file("snapshot.bin");
+    ASSERT_EQ(arena.get_npcs().size(), 2u);
+    EXPECT_EQ(arena.get_npcs().type(1), NPCType::Knight);
+    EXPECT_EQ(arena.get_npcs().x(1), -3);
+
+    arena.load_from_file("snapshot.txt");
+    EXPECT_EQ(arena.get_npcs().size(), 2u);
+}
+
+TEST_F(SnapshotTest, RejectsTruncatedFile) {
+    NPCStore store;
+    store.add(NPCType::Dragon, 1, 2);
+    Snapshot::write(store, "snapshot.bin");
+    fs::resize_file("snapshot.bin", fs::file_size("snapshot.bin") - 4);
+
+    NPCStore loaded;
+    EXPECT_THROW(Snapshot::read("snapshot.bin", loaded), std::invalid_argument);
+    EXPECT_THROW(Snapshot::write(store, "/invalid/path/snapshot.bin"), std::invalid_argument);
+}
+
+TEST_F(SnapshotTest, RejectsCraftedOffsets) {
+    NPCStore store;
+    for (int i = 0; i < 10; ++i) {
+        store.add(NPCType::Frog, i, -i);
+    }
+    Snapshot::write(store, "snapshot.bin");
+    std::string valid;
+    {
+        std::ifstream file("snapshot.bin", std::ios::binary);
+        valid.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Header fields: dictionary_offset at 24, then the x, y, type and alive offsets.
+    const auto rejects = [&valid](size_t field, std::uint64_t value) {
+        std::string bytes = valid;
+        std::memcpy(bytes.data() + field, &value, sizeof(value));
+        std::ofstream("snapshot.bin", std::ios::binary | std::ios::trunc) << bytes;
+        NPCStore loaded;
+        EXPECT_THROW(Snapshot::read("snapshot.bin", loaded), std::invalid_argument) << field << ' ' << value;
+    };
+    rejects(32, ~std::uint64_t(0) - 7);
+    rejects(40, ~std::uint64_t(0) - 7);
+    rejects(48, ~std::uint64_t(0));
+    rejects(56, ~std::uint64_t(0) - 7);
+    rejects(24, 0);
+    rejects(24, valid.size());
+}
+
+// ============== Text Loader Tests ==============
+
+class TextLoaderTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        std::remove("loader_input.txt");
+    }
+
+    static size_t error_line(const std::string& text) {
+        NPCStore store;
+        try {
+            TextLoader::parse(text, store);
+        } catch (const ParseError& error) {
+            return error.line();
+        }
+        return 0;
+    }
+};
+
+TEST_F(TextLoaderTest, ParsesWhitespaceVariants) {
+    NPCStore store;
+    TextLoader::parse("Dragon 10 20\n\n  Frog\t-5   +15 \r\nKnight 2147483647 -2147483648", store);
+    ASSERT_EQ(store.size(), 3u);
+    EXPECT_EQ(store.get_types(), (std::vector<NPCType>{NPCType::Dragon, NPCType::Frog, NPCType::Knight}));
+    EXPECT_EQ(store.get_xs(), (std::vector<int>{10, -5, 2147483647}));
+    EXPECT_EQ(store.get_ys(), (std::vector<int>{20, 15, -2147483647 - 1}));
+
+    for (const char* text : {"Frog +-5 1", "Frog 1 +-5", "Frog ++5 1", "Frog -+5 1", "Frog + 5 1"}) {
+        EXPECT_THROW(TextLoader::parse(text, store), ParseError) << text;
+    }
+}
+
+TEST_F(TextLoaderTest, ReportsLineNumbers) {
+    EXPECT_EQ(error_line("Dragon 1 2\nFrog 1\n"), 2u);
+    EXPECT_EQ(error_line("Dragon 1 2\n\nUnicorn 1 2\n"), 3u);
+    EXPECT_EQ(error_line("Dragon x 2\n"), 1u);
+    EXPECT_EQ(error_line("Dragon 1 2 3\n"), 1u);
+    EXPECT_EQ(error_line("Dragon 1 99999999999\n"), 1u);
+    EXPECT_EQ(error_line("Dragon 1 2\nKnight 3 4"), 0u);
+}
+
+TEST_F(TextLoaderTest, FailedLoadKeepsPopulation) {
+    std::ofstream input("loader_input.txt");
+    input << "Dragon 1 2\nFrog one 2\n";
+    input.close();
+
+    Arena& arena = Arena::get_instance();
+    arena.clear_npcs();
+    arena.add_npc("Knight", 0, 0);
+    EXPECT_THROW(arena.load_from_file("loader_input.txt"), std::invalid_argument);
+    EXPECT_EQ(arena.get_npcs().size(), 1u);
+    arena.clear_npcs();
+}
+
+TEST_F(TextLoaderTest, EmptyFile) {
+    std::ofstream input("loader_input.txt");
+    input.close();
+    NPCStore store;
+    store.add(NPCType::Frog, 0, 0);
+    TextLoader::read("loader_input.txt", store);
+    EXPECT_EQ(store.size(), 0u);
+}
+
+// ============== NPC Pool Tests ==============
+
+class NPCPoolTest : public ::testing::Test {};
+
+TEST_F(NPCPoolTest, NoPerNPCUpstreamAllocations) {
+    NPCPool pool;
+    std::vector<std::shared_ptr<NPC>> npcs;
+    for (int i = 0; i < 3000; ++i) {
+        npcs.push_back(INPCFactory::create_npc(static_cast<NPCType>(i % 3), i, -i, pool));
+    }
+    EXPECT_EQ(pool.allocations(), 3000u);
+    EXPECT_LE(pool.upstream_allocations(), 16u);
+    EXPECT_EQ(npcs[1500]->x, 1500);
+    EXPECT_EQ(npcs[1501]->get_type(), "Frog");
+}
+
+TEST_F(NPCPoolTest, FreedBlocksAreReused) {
+    NPCPool pool;
+    for (int i = 0; i < 1000; ++i) {
+        auto npc = INPCFactory::create_npc(NPCType::Dragon, i, i, pool);
+    }
+    EXPECT_EQ(pool.upstream_allocations(), 1u);
+}
+
+TEST_F(NPCPoolTest, ReleaseKeepsLiveObjectsValid) {
+    NPCPool pool;
+    auto knight = INPCFactory::create_npc(NPCType::Knight, 7, 8, pool);
+    pool.release();
+    EXPECT_EQ(pool.allocations(), 0u);
+    EXPECT_EQ(pool.upstream_allocations(), 0u);
+    EXPECT_EQ(knight->x, 7);
+    EXPECT_EQ(knight->get_type(), "Knight");
+}
+
+TEST_F(NPCPoolTest, ArenaViewsComeFromPool) {
+    Arena& arena = Arena::get_instance();
+    arena.clear_npcs();
+    NPCHandle handle = arena.add_npc("Dragon", 1, 2);
+    auto npc = arena.get_npc(handle);
+    EXPECT_EQ(arena.get_npc_pool().allocations(), 1u);
+    arena.clear_npcs();
+    EXPECT_EQ(arena.get_npc_pool().allocations(), 0u);
+    EXPECT_EQ(npc->y, 2);
+}
+
+// ============== Independent Arena Tests ==============
+
+class IndependentArenaTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        for (int i = 0; i < 4; ++i) {
+            std::remove(("arena_log_" + std::to_string(i) + ".txt").c_str());
+            std::remove(("arena_res_" + std::to_string(i) + ".txt").c_str());
+        }
+    }
+};
+
+TEST_F(IndependentArenaTest, InstancesAreIndependent) {
+    Arena first(ArenaConfig{"", "", false});
+    Arena second(ArenaConfig{"", "", false});
+    first.add_npc("Dragon", 0, 0);
+    EXPECT_EQ(first.get_npcs().size(), 1u);
+    EXPECT_EQ(second.get_npcs().size(), 0u);
+    EXPECT_NE(&first, &Arena::get_instance());
+}
+
+TEST_F(IndependentArenaTest, OnlyTheSingletonWritesDefaultPaths) {
+    Arena first;
+    Arena second;
+    EXPECT_TRUE(first.get_config().log_path.empty());
+    EXPECT_TRUE(first.get_config().result_path.empty());
+    EXPECT_EQ(Arena::get_instance().get_config().log_path, "../logs.txt");
+    EXPECT_EQ(Arena::get_instance().get_config().result_path, "../res.txt");
+}
+
+TEST_F(IndependentArenaTest, OutputsGoToConfiguredPaths) {
+    Arena arena(ArenaConfig{"arena_log_0.txt", "arena_res_0.txt", false});
+    auto observer = std::make_shared<TypedObserver>();
+    arena.add_observer(observer);
+    arena.add_npc("Frog", 0, 0);
+    arena.add_npc("Dragon", 1, 1);
+
+    std::stringstream buffer;
+    std::streambuf* old = std::cout.rdbuf(buffer.rdbuf());
+    arena.battle(10);
+    std::cout.rdbuf(old);
+
+    EXPECT_EQ(observer->events.size(), 1u);
+    std::ifstream log("arena_log_0.txt");
+    std::string line;
+    ASSERT_TRUE(std::getline(log, line));
+    EXPECT_EQ(line, "Frog killed Dragon");
+    std::ifstream result("arena_res_0.txt");
+    ASSERT_TRUE(std::getline(result, line));
+    EXPECT_EQ(line, "Frog 0 0");
+}
+
+TEST_F(IndependentArenaTest, ConcurrentBattlesMatchReference) {
+    std::vector<std::vector<std::tuple<std::string, int, int>>> populations;
+    std::vector<std::string> results(4);
+    for (unsigned i = 0; i < 4; ++i) {
+        populations.push_back(random_population(400, 150, 100 + i));
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([i, &populations, &results]() {
+            const std::string result_path = "arena_res_" + std::to_string(i) + ".txt";
+            std::stringstream console;
+            Arena arena(ArenaConfig{"arena_log_" + std::to_string(i) + ".txt", result_path, true, &console});
+            for (const auto& [type, x, y] : populations[i]) {
+                arena.add_npc(type, x, y);
+            }
+            if (i % 2 == 1) {
+                arena.set_async_observers(true, 64);
+            }
+            arena.battle(100);
+            std::ifstream file(result_path);
+            std::stringstream content;
+            content << file.rdbuf();
+            results[i] = content.str();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(results[i], reference_battle(populations[i], 100));
+    }
+}
+
+// ============== Battle Stats Tests ==============
+
+class BattleStatsTest : public ::testing::Test {};
+
+TEST_F(BattleStatsTest, CountsRoundsPairsAndKills) {
+    std::stringstream console;
+    Arena arena(ArenaConfig{"", "", false, &console});
+    // Only queued rounds count the pairs that have a dead side.
+    arena.set_dense_threshold(1);
+    arena.add_npc("Frog", 0, 0);
+    arena.add_npc("Dragon", 5, 0);
+    arena.add_npc("Knight", 15, 0);
+    arena.battle(20);
+
+    const BattleStats& stats = arena.get_battle_stats();
+    ASSERT_EQ(stats.get_rounds().size(), 3u);
+    EXPECT_EQ(stats.get_npcs(), 3u);
+    EXPECT_GT(stats.get_index_distance_tests(), 0u);
+    EXPECT_EQ(stats.get_rounds()[0].in_range_pairs, 0u);
+
+    const RoundStats& first = stats.get_rounds()[1];
+    EXPECT_EQ(first.radius, 10u);
+    EXPECT_EQ(first.pairs_considered, 1u);
+    EXPECT_EQ(first.in_range_pairs, 4u);
+    EXPECT_EQ(first.kill_count(NPCType::Frog, NPCType::Dragon), 1u);
+    EXPECT_EQ(first.kill_count(NPCType::Dragon, NPCType::Knight), 0u);
+    EXPECT_EQ(first.alive, 2u);
+
+    const RoundStats total = stats.totals();
+    EXPECT_EQ(total.kill_count(), 2u);
+    EXPECT_EQ(total.alive, 1u);
+    EXPECT_EQ(total.in_range_pairs, 6u);
+}
+
+TEST_F(BattleStatsTest, ModesAgreeOnCounters) {
+    const auto population = random_population(500, 200, 7);
+    std::vector<RoundStats> totals;
+    for (ResolutionMode mode : {ResolutionMode::Sequential, ResolutionMode::Simultaneous}) {
+        std::stringstream console;
+        Arena arena(ArenaConfig{"", "", false, &console});
+        for (const auto& [type, x, y] : population) {
+            arena.add_npc(type, x, y);
+        }
+        arena.set_resolution_mode(mode);
+        arena.set_compaction_threshold(2.0);
+        arena.battle(60);
+        totals.push_back(arena.get_battle_stats().totals());
+        EXPECT_EQ(totals.back().alive, arena.get_npcs().alive_count());
+        EXPECT_EQ(totals.back().kill_count(), 500u - totals.back().alive);
+    }
+    EXPECT_EQ(totals[0].in_range_pairs, totals[1].in_range_pairs);
+}
+
+TEST_F(BattleStatsTest, WritesPrometheusAndJsonLines) {
+    std::stringstream console;
+    Arena arena(ArenaConfig{"", "", false, &console, "battle_stats.txt", StatsFormat::Prometheus});
+    arena.add_npc("Knight", 0, 0);
+    arena.add_npc("Dragon", 3, 4);
+    arena.battle(10);
+
+    std::ifstream file("battle_stats.txt");
+    std::stringstream prometheus;
+    prometheus << file.rdbuf();
+    EXPECT_NE(prometheus.str().find("# TYPE lab6_round_kills gauge"), std::string::npos);
+    EXPECT_NE(prometheus.str().find("lab6_round_kills{round=\"1\",killer=\"Knight\",victim=\"Dragon\"} 1"),
+              std::string::npos);
+    EXPECT_NE(prometheus.str().find("# TYPE lab6_kills_total counter"), std::string::npos);
+    EXPECT_NE(prometheus.str().find("lab6_kills_total{killer=\"Knight\",victim=\"Dragon\"} 1"), std::string::npos);
+    std::remove("battle_stats.txt");
+
+    std::stringstream lines;
+    arena.get_battle_stats().write(lines, StatsFormat::JsonLines);
+    std::string line;
+    ASSERT_TRUE(std::getline(lines, line));
+    EXPECT_EQ(line.rfind("{\"index\": ", 0), 0u);
+    ASSERT_TRUE(std::getline(lines, line));
+    EXPECT_NE(line.find("\"kills\": {}"), std::string::npos);
+    ASSERT_TRUE(std::getline(lines, line));
+    EXPECT_NE(line.find("\"Knight>Dragon\": 1"), std::string::npos);
+    EXPECT_FALSE(std::getline(lines, line));
+}
+
+// ============== Compaction Tests ==============
+
+class CompactionTest : public ::testing::Test {};
+
+TEST_F(CompactionTest, StoreKeepsOrderAndHandles) {
+    NPCStore store;
+    std::vector<NPCHandle> handles;
+    for (int i = 0; i < 70; ++i) {
+        handles.push_back(store.add(NPCType::Knight, i, -i));
+    }
+    store.kill(0);
+    store.kill(65);
+
+    const std::vector<std::uint32_t> remap = store.compact();
+    ASSERT_EQ(remap.size(), 70u);
+    EXPECT_EQ(remap[0], NPCStore::NO_INDEX);
+    EXPECT_EQ(remap[1], 0u);
+    EXPECT_EQ(remap[66], 64u);
+    EXPECT_EQ(store.size(), 68u);
+    EXPECT_EQ(store.alive_count(), 68u);
+    EXPECT_EQ(store.dead_count(), 0u);
+    EXPECT_EQ(store.x(64), 66);
+    EXPECT_TRUE(store.is_alive(67));
+
+    EXPECT_EQ(store.index_of(handles[66]), 64u);
+    EXPECT_TRUE(store.is_buried(handles[65]));
+    EXPECT_THROW(store.index_of(handles[65]), std::invalid_argument);
+    const NPCRecord dead = store.record(handles[65]);
+    EXPECT_EQ(dead.x, 65);
+    EXPECT_FALSE(dead.is_alive);
+    ASSERT_EQ(store.get_graveyard().size(), 2u);
+    EXPECT_EQ(store.get_graveyard()[0].handle, handles[0]);
+}
+
+TEST_F(CompactionTest, QueueDropsAndRemapsPairs) {
+    std::vector<int> xs = {0, 3, 0, 100};
+    std::vector<int> ys = {0, 4, 12, 0};
+    PairQueue queue(xs, ys, RadiusSchedule({0, 5, 10, 15}));
+    const std::vector<std::uint32_t> remap = {0, NPCStore::NO_INDEX, 1, 2};
+    queue.compact(remap, 2);
+
+    EXPECT_TRUE(queue.band(1).empty());
+    EXPECT_TRUE(queue.band(2).empty());
+    ASSERT_EQ(queue.band(3).size(), 2u);
+    EXPECT_EQ(queue.band(3)[0].attacker, 0u);
+    EXPECT_EQ(queue.band(3)[0].defender, 1u);
+    EXPECT_EQ(queue.band(3)[1].attacker, 1u);
+    EXPECT_EQ(queue.band(3)[1].defender, 0u);
+    EXPECT_EQ(queue.size(), 2u);
+}
+
+TEST_F(CompactionTest, BattleResultUnchanged) {
+    const auto population = random_population(600, 150, 23);
+    for (double threshold : {0.01, 0.5, 2.0}) {
+        std::stringstream console;
+        Arena arena(ArenaConfig{"", "compaction_res.txt", false, &console});
+        std::vector<NPCHandle> handles;
+        for (const auto& [type, x, y] : population) {
+            handles.push_back(arena.add_npc(type, x, y));
+        }
+        arena.set_compaction_threshold(threshold);
+        arena.battle(100);
+
+        std::ifstream file("compaction_res.txt");
+        std::stringstream content;
+        content << file.rdbuf();
+        EXPECT_EQ(content.str(), reference_battle(population, 100));
+
+        const RoundStats total = arena.get_battle_stats().totals();
+        EXPECT_EQ(arena.get_npcs().get_graveyard().size(), total.compacted);
+        if (threshold < 1) {
+            EXPECT_GT(total.compacted, 0u);
+        }
+        size_t dead = 0;
+        for (NPCHandle handle : handles) {
+            dead += arena.get_npc(handle)->is_alive ? 0 : 1;
+        }
+        EXPECT_EQ(dead, 600u - arena.get_npcs().alive_count());
+    }
+    std::remove("compaction_res.txt");
+    EXPECT_THROW(Arena::get_instance().set_compaction_threshold(0), std::invalid_argument);
+}
+
+// ============== Kill Log Tests ==============
+
+class KillLogTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        std::remove("kill_log.bin");
+    }
+};
+
+TEST_F(KillLogTest, RoundTripsEvents) {
+    std::vector<KillEvent> written;
+    {
+        KillLogObserver log("kill_log.bin");
+        for (std::uint32_t i = 0; i < KillLog::CHUNK + 10; ++i) {
+            KillEvent event{NPCType::Frog, static_cast<NPCType>(i % NPC_TYPE_COUNT)};
+            event.round = i / 1000;
+            event.radius = event.round * 10;
+            event.killer_id = i;
+            event.victim_id = 5000000 - i;
+            event.killer_x = -static_cast<int>(i);
+            event.killer_y = INT_MIN + static_cast<int>(i);
+            event.victim_x = INT_MAX - static_cast<int>(i);
+            event.victim_y = static_cast<int>(i % 7) - 3;
+            log.on_kill(event);
+            written.push_back(event);
+        }
+    }
+
+    const KillLogReader reader("kill_log.bin");
+    EXPECT_EQ(reader.chunk_count(), 2u);
+    std::vector<KillEvent> read;
+    EXPECT_EQ(reader.scan(KillLogFilter{}, [&read](const KillEvent& event) { read.push_back(event); }), 2u);
+    ASSERT_EQ(read.size(), written.size());
+    for (size_t i = 0; i < read.size(); ++i) {
+        EXPECT_EQ(read[i].killer, written[i].killer);
+        EXPECT_EQ(read[i].victim, written[i].victim);
+        EXPECT_EQ(read[i].round, written[i].round);
+        EXPECT_EQ(read[i].radius, written[i].radius);
+        EXPECT_EQ(read[i].killer_id, written[i].killer_id);
+        EXPECT_EQ(read[i].victim_id, written[i].victim_id);
+        EXPECT_EQ(read[i].killer_x, written[i].killer_x);
+        EXPECT_EQ(read[i].killer_y, written[i].killer_y);
+        EXPECT_EQ(read[i].victim_x, written[i].victim_x);
+        EXPECT_EQ(read[i].victim_y, written[i].victim_y);
+    }
+}
+
+TEST_F(KillLogTest, FiltersSkipChunks) {
+    {
+        KillLogObserver log("kill_log.bin");
+        for (std::uint32_t round = 0; round < 3; ++round) {
+            KillEvent event{NPCType::Knight, NPCType::Dragon};
+            event.round = round;
+            event.victim_x = static_cast<int>(round) * 100;
+            log.on_kill(event);
+            log.on_kill(event);
+            log.flush();
+        }
+    }
+
+    const KillLogReader reader("kill_log.bin");
+    EXPECT_EQ(reader.chunk_count(), 3u);
+
+    KillLogFilter filter;
+    filter.first_round = 1;
+    filter.last_round = 1;
+    size_t matched = 0;
+    EXPECT_EQ(reader.scan(filter, [&matched](const KillEvent&) { ++matched; }), 1u);
+    EXPECT_EQ(matched, 2u);
+
+    KillLogFilter region;
+    region.min_x = 150;
+    EXPECT_EQ(reader.scan(region, [](const KillEvent& event) { EXPECT_EQ(event.round, 2u); }), 1u);
+
+    KillLogFilter frogs;
+    frogs.killers = type_mask(NPCType::Frog);
+    EXPECT_EQ(reader.scan(frogs, [](const KillEvent&) { FAIL(); }), 0u);
+}
+
+TEST_F(KillLogTest, ArenaRecordsBattle) {
+    const auto population = random_population(400, 150, 31);
+    std::stringstream console;
+    ArenaConfig config{"", "", false, &console};
+    config.kill_log_path = "kill_log.bin";
+    Arena arena(config);
+    std::vector<NPCHandle> handles;
+    for (const auto& [type, x, y] : population) {
+        handles.push_back(arena.add_npc(type, x, y));
+    }
+    arena.battle(100);
+    arena.clear_observers();
+
+    const KillLogReader reader("kill_log.bin");
+    size_t kills = 0;
+    reader.scan(KillLogFilter{}, [&](const KillEvent& event) {
+        ++kills;
+        const auto victim = arena.get_npc(NPCHandle{event.victim_id});
+        EXPECT_FALSE(victim->is_alive);
+        EXPECT_EQ(victim->x, event.victim_x);
+        EXPECT_EQ(victim->get_type_id(), event.victim);
+        EXPECT_LE(NPC::squared_distance(event.killer_x, event.killer_y, event.victim_x, event.victim_y),
+                  NPC::squared_radius(event.radius));
+    });
+    EXPECT_EQ(kills, 400u - arena.get_npcs().alive_count());
+}
+
+TEST_F(KillLogTest, RecordsTypesAddedAfterOpening) {
+    std::stringstream console;
+    ArenaConfig config{"", "", false, &console};
+    config.kill_log_path = "kill_log.bin";
+    Arena arena(config);
+    const NPCType ghoul = TypeRegistry::add("Ghoul");
+    arena.set_rules(RuleTable::parse("types Ghoul Dragon\nGhoul 0 1\n"));
+    arena.add_npc("Ghoul", 0, 0);
+    arena.add_npc("Dragon", 1, 1);
+    arena.battle(10);
+    arena.clear_observers();
+
+    const KillLogReader reader("kill_log.bin");
+    EXPECT_EQ(reader.chunk_count(), 1u);
+    std::vector<KillEvent> read;
+    reader.scan(KillLogFilter{}, [&read](const KillEvent& event) { read.push_back(event); });
+    ASSERT_EQ(read.size(), 1u);
+    EXPECT_EQ(read[0].killer, ghoul);
+    EXPECT_EQ(read[0].victim, NPCType::Dragon);
+
+    KillLogFilter ghouls;
+    ghouls.killers = type_mask(ghoul);
+    size_t matched = 0;
+    EXPECT_EQ(reader.scan(ghouls, [&matched](const KillEvent&) { ++matched; }), 1u);
+    EXPECT_EQ(matched, 1u);
+}
+
+TEST_F(KillLogTest, RejectsUnknownCodesInZoneMap) {
+    {
+        KillLogObserver log("kill_log.bin");
+        log.on_kill(KillEvent{NPCType::Knight, NPCType::Dragon});
+    }
+    std::string bytes;
+    {
+        std::ifstream file("kill_log.bin", std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    const size_t chunk = bytes.find("KCHK");
+    ASSERT_NE(chunk, std::string::npos);
+    // The killer mask follows the magic, count, round range and bounding box.
+    bytes[chunk + 39] = static_cast<char>(0x80);
+    std::ofstream("kill_log.bin", std::ios::binary) << bytes;
+
+    const KillLogReader reader("kill_log.bin");
+    EXPECT_THROW(reader.scan(KillLogFilter{}, [](const KillEvent&) {}), std::invalid_argument);
+}
+
+TEST_F(KillLogTest, RejectsOtherFiles) {
+    std::ofstream("kill_log.bin") << "Dragon 1 2\n";
+    EXPECT_THROW(KillLogReader("kill_log.bin"), std::invalid_argument);
+}
+
+// ============== Spatial Index Tests ==============
+
+class SpatialIndexTest : public ::testing::Test {};
+
+TEST_F(SpatialIndexTest, AllIndexesMatchBruteForce) {
+    std::mt19937 random(5);
+    std::normal_distribution<double> spread(0.0, 30.0);
+    std::uniform_int_distribution<int> centre(-5000, 5000);
+    std::vector<int> xs;
+    std::vector<int> ys;
+    for (int cluster = 0; cluster < 5; ++cluster) {
+        const int cx = centre(random);
+        const int cy = centre(random);
+        for (int i = 0; i < 300; ++i) {
+            xs.push_back(cx + static_cast<int>(spread(random)));
+            ys.push_back(cy + static_cast<int>(spread(random)));
+        }
+    }
+    xs.push_back(INT_MIN);
+    ys.push_back(INT_MAX);
+
+    const BruteForceIndex reference(xs, ys);
+    for (SpatialIndexKind kind : {SpatialIndexKind::Grid, SpatialIndexKind::KdTree}) {
+        for (size_t radius : {size_t(0), size_t(15), size_t(100), size_t(20000), size_t(1) << 40}) {
+            const auto index = SpatialIndex::build(kind, xs, ys, radius);
+            EXPECT_EQ(index->size(), xs.size());
+            for (size_t i = 0; i < xs.size(); i += 37) {
+                std::vector<size_t> expected;
+                std::vector<size_t> actual;
+                reference.query(xs[i], ys[i], radius, expected);
+                index->query(xs[i], ys[i], radius, actual);
+                std::sort(actual.begin(), actual.end());
+                EXPECT_EQ(actual, expected);
+            }
+        }
+    }
+}
+
+TEST_F(SpatialIndexTest, KdTreeIsBalancedAndPrunes) {
+    std::vector<int> xs;
+    std::vector<int> ys;
+    for (int i = 0; i < 4096; ++i) {
+        xs.push_back(i % 2 == 0 ? i : 1000000 + i % 3);
+        ys.push_back(i % 2 == 0 ? 0 : i % 5);
+    }
+    const KdTree tree(xs, ys);
+    EXPECT_LE(tree.depth(), 10u);
+
+    std::vector<size_t> out;
+    const size_t tests = tree.query(0, 0, 100, out);
+    EXPECT_EQ(out.size(), 51u);
+    EXPECT_LT(tests, 256u);
+}
+
+TEST_F(SpatialIndexTest, BattleIsIndexIndependent) {
+    const auto population = random_population(500, 200, 41);
+    for (SpatialIndexKind kind : {SpatialIndexKind::BruteForce, SpatialIndexKind::Grid, SpatialIndexKind::KdTree}) {
+        std::stringstream console;
+        Arena arena(ArenaConfig{"", "index_res.txt", false, &console});
+        arena.set_spatial_index(kind);
+        for (const auto& [type, x, y] : population) {
+            arena.add_npc(type, x, y);
+        }
+        arena.battle(80);
+        std::ifstream file("index_res.txt");
+        std::stringstream content;
+        content << file.rdbuf();
+        EXPECT_EQ(content.str(), reference_battle(population, 80));
+    }
+    std::remove("index_res.txt");
+}
+
+TEST_F(SpatialIndexTest, RegionQueryReturnsLivingNPCs) {
+    for (SpatialIndexKind kind : {SpatialIndexKind::Grid, SpatialIndexKind::KdTree}) {
+        std::stringstream console;
+        Arena arena(ArenaConfig{"", "", false, &console});
+        arena.set_spatial_index(kind);
+        const NPCHandle frog = arena.add_npc("Frog", 0, 0);
+        const NPCHandle dragon = arena.add_npc("Dragon", 3, 4);
+        arena.add_npc("Knight", 100, 100);
+        EXPECT_EQ(arena.query_region(0, 0, 5), (std::vector<NPCHandle>{frog, dragon}));
+
+        arena.battle(10);
+        EXPECT_EQ(arena.query_region(0, 0, 5), (std::vector<NPCHandle>{frog}));
+        const NPCHandle knight = arena.add_npc("Knight", 1, 1);
+        EXPECT_EQ(arena.query_region(0, 0, 5), (std::vector<NPCHandle>{frog, knight}));
+    }
+}
+
+// ============== Type List Tests ==============
+
+class TypeListTest : public ::testing::Test {};
+
+namespace {
+
+class TypeCountingVisitor final : public NPCVisitor<TypeCountingVisitor> {
+public:
+    std::array<int, MAX_NPC_TYPES> visits{};
+
+    template<typename T>
+    void visit(T& npc) {
+        ++visits[static_cast<size_t>(npc.get_type_id())];
+    }
+};
+
+}
+
+static_assert(KillTable::victims_of(NPCType::Dragon) == Dragon::VICTIMS);
+static_assert(KillTable::victims_of(NPCType::Frog) == Frog::VICTIMS);
+static_assert(KillTable::victims_of(NPCType::Knight) == Knight::VICTIMS);
+
+TEST_F(TypeListTest, VisitMapsIdsToClasses) {
+    for (size_t i = 0; i < NPC_TYPE_COUNT; ++i) {
+        const auto type = static_cast<NPCType>(i);
+        const std::string_view name = visit_npc_type(type, []<typename T>(std::type_identity<T>) {
+            return T::NAME;
+        });
+        EXPECT_EQ(name, TypeRegistry::name(type));
+    }
+    EXPECT_THROW(visit_npc_type(static_cast<NPCType>(200), []<typename T>(std::type_identity<T>) {}),
+                 std::invalid_argument);
+}
+
+TEST_F(TypeListTest, FactoryCoversEveryType) {
+    NPCPool pool;
+    for (size_t i = 0; i < NPC_TYPE_COUNT; ++i) {
+        const auto type = static_cast<NPCType>(i);
+        EXPECT_EQ(INPCFactory::create_npc(type, 1, 2)->get_type_id(), type);
+        EXPECT_EQ(INPCFactory::create_npc(type, 1, 2, pool)->get_type(), TypeRegistry::name(type));
+    }
+}
+
+TEST_F(TypeListTest, GeneratedVisitorDispatchesStatically) {
+    TypeCountingVisitor visitor;
+    for (const char* type : {"Dragon", "Frog", "Frog", "Knight", "Knight", "Knight"}) {
+        INPCFactory::create_npc(type, 0, 0)->accept(visitor);
+    }
+    EXPECT_EQ(visitor.visits[0], 1);
+    EXPECT_EQ(visitor.visits[1], 2);
+    EXPECT_EQ(visitor.visits[2], 3);
+}
+
+// ============== Rule Table Tests ==============
+
+class RuleTableTest : public ::testing::Test {};
+
+TEST_F(RuleTableTest, RegistryInternsRuntimeTypes) {
+    const size_t before = TypeRegistry::count();
+    const NPCType elf = TypeRegistry::add("Elf");
+    EXPECT_GE(static_cast<size_t>(elf), NPC_TYPE_COUNT);
+    EXPECT_EQ(TypeRegistry::add("Elf"), elf);
+    EXPECT_EQ(TypeRegistry::find("Elf"), elf);
+    EXPECT_EQ(TypeRegistry::name(elf), "Elf");
+    EXPECT_TRUE(TypeRegistry::contains("Elf"));
+    EXPECT_LE(TypeRegistry::count(), before + 1);
+    EXPECT_EQ(TypeRegistry::add("Dragon"), NPCType::Dragon);
+    EXPECT_THROW(TypeRegistry::add(""), std::invalid_argument);
+    EXPECT_THROW(TypeRegistry::add("Wood Elf"), std::invalid_argument);
+    EXPECT_FALSE(TypeRegistry::contains("Wood Elf"));
+
+    auto npc = INPCFactory::create_npc("Elf", 3, 4);
+    EXPECT_EQ(npc->get_type_id(), elf);
+    EXPECT_EQ(npc->get_type(), "Elf");
+}
+
+TEST_F(RuleTableTest, BuiltinMatchesKillTable) {
+    const RuleTable& rules = RuleTable::builtin();
+    for (size_t a = 0; a < NPC_TYPE_COUNT; ++a) {
+        EXPECT_EQ(rules.victims_of(static_cast<NPCType>(a)), KillTable::victims_of(static_cast<NPCType>(a)));
+    }
+    EXPECT_FALSE(rules.can_kill(NPCType::Dragon, static_cast<NPCType>(200)));
+}
+
+TEST_F(RuleTableTest, ParsesRulesFile) {
+    const RuleTable rules = RuleTable::parse(
+        "# knights and orcs\n"
+        "types Dragon Knight Orc\n"
+        "\n"
+        "Dragon 0 1 0   # dragons eat knights\n"
+        "Orc    1 1 0\n");
+    const NPCType orc = TypeRegistry::find("Orc");
+    EXPECT_TRUE(rules.can_kill(NPCType::Dragon, NPCType::Knight));
+    EXPECT_TRUE(rules.can_kill(orc, NPCType::Dragon));
+    EXPECT_TRUE(rules.can_kill(orc, NPCType::Knight));
+    EXPECT_FALSE(rules.can_kill(orc, orc));
+    EXPECT_FALSE(rules.can_kill(NPCType::Knight, orc));
+    EXPECT_EQ(rules.victims_of(NPCType::Frog), 0u);
+}
+
+TEST_F(RuleTableTest, ReportsErrorsWithLineNumbers) {
+    const auto line_of = [](std::string_view text) -> size_t {
+        try {
+            RuleTable::parse(text);
+        } catch (const ParseError& error) {
+            return error.line();
+        }
+        return 0;
+    };
+    EXPECT_EQ(line_of("Dragon 1\n"), 1u);
+    EXPECT_EQ(line_of("# nothing\n"), 2u);
+    EXPECT_EQ(line_of("types Dragon Frog\nDragon 1\n"), 2u);
+    EXPECT_EQ(line_of("types Dragon Frog\n\nDragon 1 2\n"), 3u);
+    EXPECT_EQ(line_of("types Dragon Frog\nDragon 1 0\nDragon 0 0\n"), 3u);
+    EXPECT_EQ(line_of("types Dragon Dragon\n"), 1u);
+    EXPECT_EQ(line_of("types Dragon Quo\"te\n"), 1u);
+    EXPECT_EQ(line_of("types Dragon Frog\nLabel{a=b} 0 1\n"), 2u);
+}
+
+TEST_F(RuleTableTest, FailedParseRegistersNothing) {
+    const size_t before = TypeRegistry::count();
+    EXPECT_THROW(RuleTable::parse("types Dragon Wyvern\nWyvern 1 0\nBasilisk 1\n"), ParseError);
+    EXPECT_FALSE(TypeRegistry::contains("Wyvern"));
+    EXPECT_FALSE(TypeRegistry::contains("Basilisk"));
+    EXPECT_EQ(TypeRegistry::count(), before);
+
+    for (const char* name : {"Back\\slash", "Brace{", "Equals=", "Quote\"", "Dot.ted"}) {
+        EXPECT_FALSE(TypeRegistry::is_valid_name(name)) << name;
+        EXPECT_THROW(TypeRegistry::add(name), std::invalid_argument) << name;
+    }
+    EXPECT_TRUE(TypeRegistry::is_valid_name("Cave_Troll-2"));
+}
+
+TEST_F(RuleTableTest, ArenaBattlesRuntimeTypes) {
+    const NPCType troll = TypeRegistry::add("Troll");
+    Arena arena(ArenaConfig{"", "", false});
+    arena.set_rules(RuleTable::parse("types Troll Dragon\nTroll 0 1\n"));
+    EXPECT_THROW(arena.add_npc(static_cast<NPCType>(MAX_NPC_TYPES - 1), 0, 0), std::invalid_argument);
+
+    const NPCHandle first = arena.add_npc("Troll", 0, 0);
+    const NPCHandle dragon = arena.add_npc(NPCType::Dragon, 5, 0);
+    const NPCHandle knight = arena.add_npc(NPCType::Knight, 500, 0);
+    arena.battle(10);
+
+    EXPECT_TRUE(arena.get_npc(first)->is_alive);
+    EXPECT_FALSE(arena.get_npc(dragon)->is_alive);
+    EXPECT_TRUE(arena.get_npc(knight)->is_alive);
+    EXPECT_EQ(arena.get_battle_stats().totals().kill_count(troll, NPCType::Dragon), 1u);
+    EXPECT_EQ(arena.get_npc(first)->get_type(), "Troll");
+
+    std::vector<std::shared_ptr<IObserver>> obs;
+    auto attacker = arena.get_npc(first);
+    auto victim = INPCFactory::create_npc(NPCType::Dragon, 0, 0);
+    BattleVisitor visitor(attacker, obs, arena.get_rules());
+    victim->accept(visitor);
+    EXPECT_FALSE(victim->is_alive);
+}
+
+// ============== Population Tests ==============
+
+class PopulationTest : public ::testing::Test {};
+
+TEST_F(PopulationTest, AddNpcsAppendsColumns) {
+    Arena arena(ArenaConfig{"", "", false});
+    arena.add_npc("Dragon", 0, 0);
+    const std::vector<int> xs = {1, 2, 3};
+    const std::vector<int> ys = {4, 5, 6};
+    const std::vector<NPCType> types = {NPCType::Frog, NPCType::Knight, NPCType::Dragon};
+
+    const NPCHandle first = arena.add_npcs(xs, ys, types);
+    EXPECT_EQ(first.id, 1u);
+    EXPECT_EQ(arena.get_npcs().size(), 4u);
+    EXPECT_EQ(arena.get_npc(NPCHandle{first.id + 1})->get_type(), "Knight");
+    EXPECT_EQ(arena.get_npc(NPCHandle{first.id + 2})->y, 6);
+
+    EXPECT_THROW(arena.add_npcs(xs, std::vector<int>{1}, types), std::invalid_argument);
+    const std::vector<NPCType> unknown = {NPCType::Frog, static_cast<NPCType>(MAX_NPC_TYPES - 1), NPCType::Frog};
+    EXPECT_THROW(arena.add_npcs(xs, ys, unknown), std::invalid_argument);
+    EXPECT_EQ(arena.get_npcs().size(), 4u);
+}
+
+TEST_F(PopulationTest, GeneratorIsThreadCountIndependent) {
+    for (Distribution distribution : {Distribution::Uniform, Distribution::Clustered, Distribution::Line}) {
+        PopulationSpec spec;
+        spec.count = 2 * PopulationGenerator::BLOCK + 17;
+        spec.seed = 7;
+        spec.distribution = distribution;
+
+        ThreadPool one(1);
+        ThreadPool four(4);
+        const Population serial = PopulationGenerator::generate(spec, one);
+        const Population parallel = PopulationGenerator::generate(spec, four);
+        ASSERT_EQ(serial.x.size(), spec.count);
+        EXPECT_EQ(serial.x, parallel.x);
+        EXPECT_EQ(serial.y, parallel.y);
+        EXPECT_EQ(serial.types, parallel.types);
+
+        spec.seed = 8;
+        EXPECT_NE(PopulationGenerator::generate(spec, four).x, serial.x);
+    }
+}
+
+TEST_F(PopulationTest, GeneratorHonoursSpec) {
+    PopulationSpec spec;
+    spec.count = 5000;
+    spec.extent = 100;
+    spec.type_weights = {0, 1, 0};
+    const Population population = PopulationGenerator::generate(spec);
+    EXPECT_TRUE(std::all_of(population.types.begin(), population.types.end(),
+                            [](NPCType type) { return type == NPCType::Frog; }));
+    EXPECT_TRUE(std::all_of(population.x.begin(), population.x.end(), [](int x) { return x >= -50 && x <= 50; }));
+    EXPECT_TRUE(std::all_of(population.y.begin(), population.y.end(), [](int y) { return y >= -50 && y <= 50; }));
+
+    spec.type_weights = {0, 0, 0};
+    EXPECT_THROW(PopulationGenerator::generate(spec), std::invalid_argument);
+    spec.type_weights = std::vector<double>(MAX_NPC_TYPES + 1, 1.0);
+    EXPECT_THROW(PopulationGenerator::generate(spec), std::invalid_argument);
+    EXPECT_THROW(PopulationGenerator::parse_distribution("spiral"), std::invalid_argument);
+
+    PopulationSpec stacked;
+    stacked.count = 3000;
+    stacked.distribution = Distribution::Clustered;
+    stacked.clusters = 2;
+    stacked.spread = 0;
+    const Population points = PopulationGenerator::generate(stacked);
+    std::set<std::pair<int, int>> distinct;
+    for (size_t i = 0; i < points.x.size(); ++i) {
+        distinct.emplace(points.x[i], points.y[i]);
+    }
+    EXPECT_LE(distinct.size(), 2u);
+}
+
+TEST_F(PopulationTest, ArenaPopulateIsReproducible) {
+    PopulationSpec spec;
+    spec.count = 3000;
+    spec.distribution = Distribution::Clustered;
+
+    Arena first(ArenaConfig{"", "", false});
+    Arena second(ArenaConfig{"", "", false});
+    first.set_thread_count(3);
+    EXPECT_EQ(first.populate(spec).id, 0u);
+    second.populate(spec);
+    EXPECT_EQ(first.get_npcs().get_xs(), second.get_npcs().get_xs());
+    EXPECT_EQ(first.get_npcs().get_types(), second.get_npcs().get_types());
+
+    first.battle(20);
+    second.battle(20);
+    EXPECT_EQ(first.get_npcs().alive_count(), second.get_npcs().alive_count());
+}
+
+// ============== Survivor Report Tests ==============
+
+class SurvivorReportTest : public ::testing::Test {
+protected:
+    static std::vector<std::string> lines(const std::string& text) {
+        std::vector<std::string> result;
+        std::stringstream stream(text);
+        std::string line;
+        while (std::getline(stream, line)) {
+            result.push_back(line);
+        }
+        return result;
+    }
+};
+
+TEST_F(SurvivorReportTest, FullListsSurvivorsEveryRound) {
+    std::stringstream console;
+    Arena arena(ArenaConfig{"", "", false, &console});
+    arena.add_npc("Dragon", 0, 0);
+    arena.add_npc("Knight", 15, 0);
+    arena.battle(20);
+
+    EXPECT_EQ(lines(console.str()), (std::vector<std::string>{
+        "Dragon 0 0", "Knight 15 0",
+        "Dragon 0 0", "Knight 15 0",
+        "Dragon 0 0", "Knight 15 0"}));
+}
+
+TEST_F(SurvivorReportTest, SummaryPrintsPerTypeCounts) {
+    std::stringstream console;
+    Arena arena(ArenaConfig{"", "", false, &console});
+    arena.set_survivor_report(SurvivorReport::Summary);
+    arena.add_npc("Frog", 0, 0);
+    arena.add_npc("Knight", 5, 0);
+    arena.add_npc("Knight", 15, 0);
+    arena.add_npc("Dragon", 1000, 0);
+    arena.battle(20);
+
+    const std::vector<std::string> output = lines(console.str());
+    ASSERT_EQ(output.size(), 3u);
+    EXPECT_EQ(output[0].rfind("Round 0 radius 0: Dragon 1 Frog 1 Knight 2", 0), 0u);
+    EXPECT_EQ(output[1].rfind("Round 1 radius 10: Dragon 1 Frog 1 Knight 2", 0), 0u);
+    EXPECT_EQ(output[2].rfind("Round 2 radius 20: Dragon 1 Frog 1 Knight 1", 0), 0u);
+}
+
+TEST_F(SurvivorReportTest, SampledCapsOutput) {
+    std::stringstream console;
+    Arena arena(ArenaConfig{"", "", false, &console});
+    arena.set_survivor_report(SurvivorReport::Sampled, 10);
+    for (int i = 0; i < 1000; ++i) {
+        arena.add_npc(NPCType::Frog, i * 100, 0);
+    }
+    arena.battle(20);
+
+    const std::vector<std::string> output = lines(console.str());
+    ASSERT_EQ(output.size(), 3u * 11u);
+    EXPECT_EQ(output[0], "Round 0 radius 0: Frog 1000");
+    EXPECT_EQ(output[1], "Frog 0 0");
+    EXPECT_EQ(output[2], "Frog 10000 0");
+
+    for (size_t size : {5, 100, 1001}) {
+        std::stringstream uneven;
+        Arena sampled(ArenaConfig{"", "", false, &uneven});
+        sampled.set_survivor_report(SurvivorReport::Sampled, 16);
+        for (size_t i = 0; i < size; ++i) {
+            sampled.add_npc(NPCType::Frog, static_cast<int>(i) * 100, 0);
+        }
+        sampled.battle(0);
+        EXPECT_EQ(lines(uneven.str()).size(), 1 + std::min<size_t>(size, 16)) << size;
+    }
+}
+
+TEST_F(SurvivorReportTest, FinalOnlyAndOff) {
+    std::stringstream console;
+    Arena arena(ArenaConfig{"", "", false, &console});
+    arena.set_survivor_report(SurvivorReport::FinalOnly);
+    arena.add_npc("Knight", 0, 0);
+    arena.add_npc("Dragon", 15, 0);
+    arena.add_npc("Dragon", 1000, 0);
+    arena.battle(20);
+    EXPECT_EQ(lines(console.str()), (std::vector<std::string>{"Knight 0 0", "Dragon 1000 0"}));
+
+    console.str("");
+    arena.set_survivor_report(SurvivorReport::Off);
+    arena.battle(20);
+    EXPECT_TRUE(console.str().empty());
+}
+
+// ============== Dense Kernel Tests ==============
+
+class DenseKernelTest : public ::testing::Test {};
+
+TEST_F(DenseKernelTest, BandRowsMatchScalarScan) {
+    std::mt19937 random(5);
+    std::uniform_int_distribution<int> coordinate(-300, 300);
+    std::vector<int> xs(5000);
+    std::vector<int> ys(5000);
+    for (size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = coordinate(random);
+        ys[i] = coordinate(random);
+    }
+    std::vector<std::uint64_t> candidates((xs.size() + 63) / 64, ~std::uint64_t(0));
+    candidates.back() &= (std::uint64_t(1) << (xs.size() % 64)) - 1;
+    candidates[3] = 0;
+    candidates[10] &= 0x00FF00FF00FF00FFULL;
+
+    const size_t words = candidates.size();
+    const auto candidate = [&](size_t i) { return ((candidates[i / 64] >> (i % 64)) & 1) != 0; };
+    for (const std::optional<size_t> inner : {std::optional<size_t>(), std::optional<size_t>(100)}) {
+        std::vector<std::uint64_t> rows;
+        const size_t first = 128;
+        DenseKernel::band_rows(xs, ys, first, DenseKernel::BLOCK, inner, 200, candidates, rows);
+        ASSERT_EQ(rows.size(), DenseKernel::BLOCK * words);
+        for (size_t a = 0; a < DenseKernel::BLOCK; ++a) {
+            const size_t i = first + a;
+            for (size_t j = 0; j < xs.size(); ++j) {
+                const bool expected = candidate(i) && candidate(j) && i != j &&
+                                      NPC::is_close(xs[i], ys[i], xs[j], ys[j], 200) &&
+                                      !(inner && NPC::is_close(xs[i], ys[i], xs[j], ys[j], *inner));
+                ASSERT_EQ(((rows[a * words + j / 64] >> (j % 64)) & 1) != 0, expected) << i << ' ' << j;
+            }
+        }
+    }
+}
+
+TEST_F(DenseKernelTest, FirstDenseRoundFollowsNeighbourFraction) {
+    const std::vector<int> xs = {0, 99, 0, 99};
+    const std::vector<int> ys = {0, 0, 99, 99};
+    const RadiusSchedule schedule = RadiusSchedule::linear(100, 10);
+    // pi * r^2 / 100^2 first exceeds 0.25 at r = 30.
+    EXPECT_EQ(DenseKernel::first_dense_round(xs, ys, schedule, 0.25), 3u);
+    EXPECT_EQ(DenseKernel::first_dense_round(xs, ys, schedule, 0), 1u);
+    EXPECT_EQ(DenseKernel::first_dense_round(xs, ys, schedule, 1), schedule.rounds());
+    EXPECT_EQ(DenseKernel::first_dense_round({0}, {0}, schedule, 0), schedule.rounds());
+}
+
+TEST_F(DenseKernelTest, LineMapsStaySparse) {
+    PopulationSpec spec;
+    spec.count = 2000;
+    spec.distribution = Distribution::Line;
+    const Population line = PopulationGenerator::generate(spec);
+    const RadiusSchedule schedule = RadiusSchedule::linear(500, 10);
+
+    size_t in_range = 0;
+    const size_t radius = schedule.radius(schedule.rounds() - 1);
+    for (size_t i = 0; i < line.x.size(); i += 10) {
+        for (size_t j = 0; j < line.x.size(); ++j) {
+            in_range += NPC::squared_distance(line.x[i], line.y[i], line.x[j], line.y[j]) <=
+                        NPC::squared_radius(radius);
+        }
+    }
+    const double fraction = static_cast<double>(in_range) / (line.x.size() / 10 * line.x.size());
+    ASSERT_LT(fraction, 0.1);
+    EXPECT_EQ(DenseKernel::first_dense_round(line.x, line.y, schedule, 0.1), schedule.rounds());
+    EXPECT_LT(DenseKernel::first_dense_round(line.x, line.y, schedule, fraction / 4), schedule.rounds());
+}
+
+TEST_F(DenseKernelTest, DenseBattleMatchesQueue) {
+    for (ResolutionMode mode : {ResolutionMode::Sequential, ResolutionMode::Simultaneous}) {
+        const auto population = random_population(600, 150, 21);
+        std::vector<std::string> results;
+        std::vector<BattleStats> stats;
+        for (double threshold : {1.0, 0.0}) {
+            const std::string path = "dense_res.txt";
+            Arena arena(ArenaConfig{"", path, false});
+            arena.set_survivor_report(SurvivorReport::Off);
+            arena.set_resolution_mode(mode);
+            arena.set_thread_count(3);
+            arena.set_dense_threshold(threshold);
+            for (const auto& [type, x, y] : population) {
+                arena.add_npc(type, x, y);
+            }
+            arena.battle(120);
+            std::ifstream file(path);
+            std::stringstream content;
+            content << file.rdbuf();
+            results.push_back(content.str());
+            stats.push_back(arena.get_battle_stats());
+            std::remove(path.c_str());
+        }
+        EXPECT_EQ(results[0], results[1]);
+        ASSERT_EQ(stats[0].get_rounds().size(), stats[1].get_rounds().size());
+        for (size_t round = 0; round < stats[0].get_rounds().size(); ++round) {
+            const RoundStats& queued = stats[0].get_rounds()[round];
+            const RoundStats& dense = stats[1].get_rounds()[round];
+            EXPECT_EQ(queued.kills, dense.kills);
+            EXPECT_EQ(queued.pairs_considered, dense.pairs_considered);
+            EXPECT_EQ(queued.alive, dense.alive);
+        }
+        EXPECT_GT(stats[1].get_rounds().back().distance_tests, 0u);
+        EXPECT_LT(stats[1].get_index_distance_tests(), stats[0].get_index_distance_tests());
+    }
+    Arena arena(ArenaConfig{"", "", false});
+    EXPECT_THROW(arena.set_dense_threshold(-0.5), std::invalid_argument);
+}
+
+// ============== Aggregating Observer Tests ==============
+
+class AggregatingObserverTest : public ::testing::Test {};
+
+TEST_F(AggregatingObserverTest, CountsTotalsAndRounds) {
+    AggregatingObserver observer(NPC_TYPE_COUNT);
+    KillEvent event{NPCType::Frog, NPCType::Dragon};
+    observer.on_kill(event);
+    observer.on_kill(event);
+    event.round = 3;
+    observer.on_kill(event);
+    event.killer = NPCType::Knight;
+    observer.on_kill(event);
+    observer.on_kill(KillEvent{static_cast<NPCType>(NPC_TYPE_COUNT), NPCType::Frog});
+
+    EXPECT_EQ(observer.total(), 4u);
+    EXPECT_EQ(observer.total(NPCType::Frog, NPCType::Dragon), 3u);
+    EXPECT_EQ(observer.total(NPCType::Knight, NPCType::Dragon), 1u);
+    EXPECT_EQ(observer.in_round(0, NPCType::Frog, NPCType::Dragon), 2u);
+    EXPECT_EQ(observer.in_round(3, NPCType::Frog, NPCType::Dragon), 1u);
+    EXPECT_EQ(observer.in_round(3), 2u);
+    EXPECT_EQ(observer.in_round(1), 0u);
+    EXPECT_EQ(observer.rounds_seen(), 4u);
+    EXPECT_EQ(observer.untracked_count(), 1u);
+
+    observer.reset();
+    EXPECT_EQ(observer.total(), 0u);
+    EXPECT_EQ(observer.in_round(0), 0u);
+    EXPECT_THROW(AggregatingObserver(0), std::invalid_argument);
+}
+
+TEST_F(AggregatingObserverTest, HistoryRecyclesSlots) {
+    AggregatingObserver observer(NPC_TYPE_COUNT);
+    KillEvent event{NPCType::Dragon, NPCType::Knight};
+    observer.on_kill(event);
+    event.round = AggregatingObserver::HISTORY;
+    observer.on_kill(event);
+    observer.on_kill(event);
+
+    EXPECT_EQ(observer.in_round(0), 0u);
+    EXPECT_EQ(observer.in_round(AggregatingObserver::HISTORY), 2u);
+    EXPECT_EQ(observer.total(NPCType::Dragon, NPCType::Knight), 3u);
+}
+
+TEST_F(AggregatingObserverTest, MatchesBattleStats) {
+    for (bool async : {false, true}) {
+        Arena arena(ArenaConfig{"", "", false});
+        arena.set_survivor_report(SurvivorReport::Off);
+        auto observer = std::make_shared<AggregatingObserver>();
+        arena.add_observer(observer);
+        arena.set_async_observers(async, 64);
+        for (const auto& [type, x, y] : random_population(500, 200, 17)) {
+            arena.add_npc(type, x, y);
+        }
+        arena.battle(60);
+
+        const BattleStats& stats = arena.get_battle_stats();
+        const RoundStats totals = stats.totals();
+        EXPECT_EQ(observer->total(), totals.kill_count());
+        for (size_t killer = 0; killer < NPC_TYPE_COUNT; ++killer) {
+            for (size_t victim = 0; victim < NPC_TYPE_COUNT; ++victim) {
+                const auto k = static_cast<NPCType>(killer);
+                const auto v = static_cast<NPCType>(victim);
+                EXPECT_EQ(observer->total(k, v), totals.kill_count(k, v));
+            }
+        }
+        for (const RoundStats& round : stats.get_rounds()) {
+            EXPECT_EQ(observer->in_round(round.round), round.kill_count());
+        }
+    }
+}
+
+TEST_F(AggregatingObserverTest, QueryableWhileBattleRuns) {
+    Arena arena(ArenaConfig{"", "", false});
+    arena.set_survivor_report(SurvivorReport::Off);
+    auto observer = std::make_shared<AggregatingObserver>();
+    arena.add_observer(observer);
+    for (const auto& [type, x, y] : random_population(3000, 400, 3)) {
+        arena.add_npc(type, x, y);
+    }
+
+    std::atomic<bool> done{false};
+    std::uint64_t last = 0;
+    bool monotonic = true;
+    std::thread reader([&]() {
+        while (!done.load()) {
+            const std::uint64_t now = observer->total();
+            monotonic = monotonic && now >= last;
+            last = now;
+            observer->in_round(observer->rounds_seen());
+        }
+    });
+    arena.battle(100);
+    done = true;
+    reader.join();
+
+    EXPECT_TRUE(monotonic);
+    EXPECT_EQ(observer->total(), arena.get_battle_stats().totals().kill_count());
+}
+
+// ============== Batched Observer Tests ==============
+
+namespace {
+
+class RoundRecorder : public IObserver {
+public:
+    std::vector<std::string> calls;
+    size_t spans = 0;
+    size_t kills = 0;
+    bool in_order = true;
+    std::uint32_t current = 0;
+
+    void on_round_begin(std::uint32_t round, std::uint64_t) override {
+        calls.push_back("begin " + std::to_string(round));
+        current = round;
+    }
+
+    void on_round(std::span<const KillEvent> events) override {
+        spans++;
+        kills += events.size();
+        for (const KillEvent& event : events) {
+            in_order = in_order && event.round == current;
+        }
+    }
+
+    void on_round_end(std::uint32_t round) override {
+        calls.push_back("end " + std::to_string(round));
+    }
+};
+
+}
+
+class BatchedObserverTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        std::remove("batched_fight.txt");
+    }
+};
+
+TEST_F(BatchedObserverTest, RoundHooksBracketKills) {
+    for (bool async : {false, true}) {
+        Arena arena(ArenaConfig{"", "", false});
+        arena.set_survivor_report(SurvivorReport::Off);
+        auto observer = std::make_shared<RoundRecorder>();
+        arena.add_observer(observer);
+        arena.set_async_observers(async, 64);
+        for (const auto& [type, x, y] : random_population(500, 200, 23)) {
+            arena.add_npc(type, x, y);
+        }
+        arena.battle(60);
+
+        const BattleStats& stats = arena.get_battle_stats();
+        ASSERT_EQ(observer->calls.size(), 2 * stats.get_rounds().size());
+        for (size_t round = 0; round < stats.get_rounds().size(); ++round) {
+            EXPECT_EQ(observer->calls[2 * round], "begin " + std::to_string(round));
+            EXPECT_EQ(observer->calls[2 * round + 1], "end " + std::to_string(round));
+        }
+        EXPECT_TRUE(observer->in_order);
+        EXPECT_EQ(observer->kills, stats.totals().kill_count());
+        if (!async) {
+            EXPECT_LE(observer->spans, stats.get_rounds().size());
+        }
+    }
+}
+
+TEST_F(BatchedObserverTest, ConsoleBatchMatchesPerKillOutput) {
+    const std::vector<KillEvent> events = {{NPCType::Dragon, NPCType::Knight},
+                                           {NPCType::Knight, NPCType::Dragon},
+                                           {NPCType::Frog, NPCType::Frog}};
+    std::ostringstream batched;
+    IConsoleObserver(batched).on_round(events);
+
+    std::ostringstream single;
+    IConsoleObserver observer(single);
+    for (const KillEvent& event : events) {
+        observer.on_kill(event);
+    }
+
+    EXPECT_EQ(batched.str(), single.str());
+    EXPECT_EQ(batched.str(), "Dragon killed Knight\nKnight killed Dragon\nFrog killed Frog\n");
+}
+
+TEST_F(BatchedObserverTest, FileObserverWritesWholeRound) {
+    {
+        FileObserver observer("batched_fight.txt");
+        const std::vector<KillEvent> events(100, KillEvent{NPCType::Knight, NPCType::Dragon});
+        observer.on_round_begin(0, 10);
+        observer.on_round(events);
+        observer.on_round_end(0);
+    }
+    std::ifstream file("batched_fight.txt");
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(file, line)) {
+        EXPECT_EQ(line, "Knight killed Dragon");
+        lines++;
+    }
+    EXPECT_EQ(lines, 100u);
+}
+
+// ============== Mapped Log Tests ==============
+
+class MappedLogTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        for (const char* path : {"mapped.txt", "mapped.txt.1", "mapped.txt.2", "mapped.txt.3"}) {
+            std::remove(path);
+        }
+    }
+};
+
+TEST_F(MappedLogTest, AppendsAcrossChunksAndTrims) {
+    std::string expected;
+    {
+        MappedLog log("mapped.txt");
+        for (int i = 0; expected.size() <= MappedLog::CHUNK; ++i) {
+            log << i << ' ' << -i << '\n';
+            expected += std::to_string(i) + ' ' + std::to_string(-i) + '\n';
+        }
+        EXPECT_EQ(log.size(), expected.size());
+        log.sync();
+        EXPECT_THROW(MappedLog second("mapped.txt"), std::runtime_error);
+    }
+    {
+        MappedLog log("mapped.txt");
+        log << std::string_view("tail\n");
+        expected += "tail\n";
+    }
+
+    EXPECT_EQ(std::filesystem::file_size("mapped.txt"), expected.size());
+    std::ifstream file("mapped.txt", std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content, expected);
+}
+
+TEST_F(MappedLogTest, ReopeningSkipsPaddingLeftByCrash) {
+    {
+        std::ofstream file("mapped.txt", std::ios::binary);
+        file << "first\n" << std::string(MappedLog::CHUNK - 6, '\0');
+    }
+    {
+        MappedLog log("mapped.txt");
+        EXPECT_EQ(log.size(), 6u);
+        log << std::string_view("second\n");
+    }
+    std::ifstream file("mapped.txt", std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content, "first\nsecond\n");
+
+    std::ofstream("mapped.txt", std::ios::binary) << std::string(MappedLog::CHUNK, '\0');
+    EXPECT_EQ(MappedLog("mapped.txt").size(), 0u);
+    EXPECT_EQ(std::filesystem::file_size("mapped.txt"), 0u);
+}
+
+TEST_F(MappedLogTest, ObserverRotatesAtConfiguredSize) {
+    const std::string line = "Knight killed Dragon\n";
+    {
+        MappedLogObserver observer("mapped.txt", 100);
+        ASSERT_TRUE(observer.is_open());
+        EXPECT_THROW(MappedLogObserver("mapped.txt"), std::runtime_error);
+        EXPECT_FALSE(MappedLogObserver("missing_dir/mapped.txt").is_open());
+        const std::vector<KillEvent> events(12, KillEvent{NPCType::Knight, NPCType::Dragon});
+        observer.on_round_begin(0, 10);
+        observer.on_round(events);
+        observer.on_round_end(0);
+    }
+
+    size_t lines = 0;
+    for (const char* path : {"mapped.txt.1", "mapped.txt.2", "mapped.txt"}) {
+        ASSERT_TRUE(std::filesystem::exists(path));
+        EXPECT_LT(std::filesystem::file_size(path), 100 + line.size());
+        std::ifstream file(path);
+        std::string read;
+        while (std::getline(file, read)) {
+            EXPECT_EQ(read + '\n', line);
+            lines++;
+        }
+    }
+    EXPECT_FALSE(std::filesystem::exists("mapped.txt.3"));
+    EXPECT_EQ(lines, 12u);
+}
+
+TEST_F(MappedLogTest, ArenasCannotShareALog) {
+    Arena first(ArenaConfig{"mapped.txt", "", false});
+    EXPECT_THROW(Arena(ArenaConfig{"mapped.txt", "", false}), std::runtime_error);
+}
+
+TEST_F(MappedLogTest, ArenaUsesConfiguredRotation) {
+    ArenaConfig config{"mapped.txt", "", false};
+    config.survivor_report = SurvivorReport::Off;
+    config.log_rotate_bytes = 64;
+    config.log_sync_interval = std::chrono::milliseconds(50);
+    size_t kills = 0;
+    {
+        Arena arena(config);
+        for (const auto& [type, x, y] : random_population(300, 100, 5)) {
+            arena.add_npc(type, x, y);
+        }
+        arena.battle(40);
+        kills = arena.get_battle_stats().totals().kill_count();
+    }
+    ASSERT_GT(kills, 10u);
+    EXPECT_TRUE(std::filesystem::exists("mapped.txt.1"));
+    for (size_t i = 1; std::filesystem::exists("mapped.txt." + std::to_string(i)); ++i) {
+        std::remove(("mapped.txt." + std::to_string(i)).c_str());
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();